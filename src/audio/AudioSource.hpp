@@ -2,15 +2,63 @@
 #define _AUDIOSOURCE_HPP
 
 #include <stdexcept>
-#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 
 namespace Audio {
 
 class AudioSource {
   public:
     virtual ~AudioSource() {}
-    virtual void read(std::vector<double> &samples) = 0;
+    /* Read up to count frames of interleaved samples (count * getChannels()
+     * samples), returns number of frames read */
+    virtual size_t read(double *samples, size_t count) = 0;
     virtual unsigned int getSampleRate() = 0;
+    virtual unsigned int getChannels() {
+        return 1;
+    }
+    /* Length in frames, 0 if not known (streams, live sources) */
+    virtual uint64_t getFrames() {
+        return 0;
+    }
+    /* Seek to frame, clamped at the end of the source, returns false if the
+     * source can't seek */
+    virtual bool seek(uint64_t frame) {
+        (void)frame;
+        return false;
+    }
+    /* Switch to another sample rate without interrupting reads, returns
+     * false if the source can't (or is still switching). The samples of a
+     * read() are all at the getSampleRate() that follows it. */
+    virtual bool setSampleRate(unsigned int sampleRate) {
+        (void)sampleRate;
+        return false;
+    }
+    /* A switch of sample rate is still under way: neither read at the new
+     * rate yet, nor given up on */
+    virtual bool isSwitchingSampleRate() {
+        return false;
+    }
+    /* Capture time of the first sample returned by the last read(), the
+     * epoch if the source doesn't know */
+    virtual std::chrono::steady_clock::time_point getReadTimestamp() {
+        return std::chrono::steady_clock::time_point();
+    }
+
+    /* Debug Statistics: overflows, underflows, samples lost, and latency in milliseconds */
+    virtual size_t getDebugOverflows() {
+        return 0;
+    }
+    virtual size_t getDebugUnderflows() {
+        return 0;
+    }
+    virtual size_t getDebugSamplesLost() {
+        return 0;
+    }
+    virtual unsigned int getDebugLatency() {
+        return 0;
+    }
 };
 
 class OpenException : public std::runtime_error {
@@ -18,6 +66,12 @@ class OpenException : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
+/* Audio format not supported by the source */
+class FormatException : public OpenException {
+  public:
+    using OpenException::OpenException;
+};
+
 class ReadException : public std::runtime_error {
   public:
     using std::runtime_error::runtime_error;
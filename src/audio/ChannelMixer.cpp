@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <string>
+
+#include "ChannelMixer.hpp"
+
+namespace Audio {
+
+ChannelMixer::ChannelMixer(unsigned int inputChannels, Mode mode, unsigned int channel) : inputChannels(inputChannels), mode(mode), channel(channel) {
+    if (inputChannels == 0)
+        throw ChannelException("Error: audio source has no channels.");
+    if (mode == Mode::Single && channel >= inputChannels)
+        throw ChannelException("Error: channel " + std::to_string(channel) + " requested, audio source has " + std::to_string(inputChannels) + " channels.");
+    if ((mode == Mode::Mid || mode == Mode::Side) && inputChannels != 2)
+        throw ChannelException("Error: mid/side requires two channels, audio source has " + std::to_string(inputChannels) + " channels.");
+}
+
+void ChannelMixer::process(const double *input, size_t frames, double *const *outputs) const {
+    const size_t N = inputChannels;
+
+    switch (mode) {
+    case Mode::All:
+        if (N == 1) {
+            std::copy(input, input + frames, outputs[0]);
+        } else if (N == 2) {
+            /* Stereo deinterleave in one pass */
+            double *left = outputs[0], *right = outputs[1];
+            for (size_t i = 0; i < frames; i++) {
+                left[i] = input[2 * i];
+                right[i] = input[2 * i + 1];
+            }
+        } else {
+            for (size_t c = 0; c < N; c++) {
+                double *output = outputs[c];
+                for (size_t i = 0; i < frames; i++)
+                    output[i] = input[i * N + c];
+            }
+        }
+        break;
+    case Mode::Single: {
+        double *output = outputs[0];
+        for (size_t i = 0; i < frames; i++)
+            output[i] = input[i * N + channel];
+        break;
+    }
+    case Mode::Mix: {
+        double *output = outputs[0];
+        double scale = 1.0 / static_cast<double>(N);
+        for (size_t i = 0; i < frames; i++) {
+            double sum = 0;
+            for (size_t c = 0; c < N; c++)
+                sum += input[i * N + c];
+            output[i] = sum * scale;
+        }
+        break;
+    }
+    case Mode::Mid: {
+        double *output = outputs[0];
+        for (size_t i = 0; i < frames; i++)
+            output[i] = 0.5 * (input[2 * i] + input[2 * i + 1]);
+        break;
+    }
+    case Mode::Side: {
+        double *output = outputs[0];
+        for (size_t i = 0; i < frames; i++)
+            output[i] = 0.5 * (input[2 * i] - input[2 * i + 1]);
+        break;
+    }
+    }
+}
+
+unsigned int ChannelMixer::getInputChannels() const {
+    return inputChannels;
+}
+
+unsigned int ChannelMixer::getOutputChannels() const {
+    return (mode == Mode::All) ? inputChannels : 1;
+}
+
+ChannelMixer::Mode ChannelMixer::getMode() const {
+    return mode;
+}
+}
@@ -0,0 +1,41 @@
+#ifndef _CHANNELMIXER_HPP
+#define _CHANNELMIXER_HPP
+
+#include <stdexcept>
+#include <cstddef>
+
+namespace Audio {
+
+/* Turns interleaved frames of an N-channel source into planar channels for
+ * analysis, in one pass: every channel, one channel, the mix of all, or the
+ * mid/side of a stereo pair. */
+class ChannelMixer {
+  public:
+    enum class Mode { All,
+                      Single,
+                      Mix,
+                      Mid,
+                      Side };
+
+    ChannelMixer(unsigned int inputChannels, Mode mode, unsigned int channel = 0);
+
+    /* Mix frames of interleaved input into getOutputChannels() planar outputs */
+    void process(const double *input, size_t frames, double *const *outputs) const;
+
+    unsigned int getInputChannels() const;
+    unsigned int getOutputChannels() const;
+    Mode getMode() const;
+
+  private:
+    const unsigned int inputChannels;
+    const Mode mode;
+    const unsigned int channel;
+};
+
+class ChannelException : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+
+#endif
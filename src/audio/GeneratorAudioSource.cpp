@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <map>
+
+#include "GeneratorAudioSource.hpp"
+
+namespace Audio {
+
+/* Samples generated per block, a multiple of the four oscillator lanes */
+static const size_t BlockSize = 4096;
+/* Samples per piecewise linear segment of a chirp, a multiple of four */
+static const uint64_t SegmentLength = 256;
+/* Amplitude of generated signals */
+static const double Amplitude = 0.5;
+/* Longest CW keying edge in seconds */
+static const double EdgeSeconds = 0.005;
+
+static std::vector<std::string> split(const std::string &s, char delimiter) {
+    std::vector<std::string> fields;
+    size_t start = 0, end;
+    while ((end = s.find(delimiter, start)) != std::string::npos) {
+        fields.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    fields.push_back(s.substr(start));
+    return fields;
+}
+
+/* Parse a whole count, nothing but digits */
+static unsigned int parseCount(const std::string &s) {
+    if (s.empty() || s.size() > 9 || !std::all_of(s.begin(), s.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+        throw std::invalid_argument("Invalid count " + s);
+    return static_cast<unsigned int>(std::stoul(s));
+}
+
+GeneratorAudioSource::Signal GeneratorAudioSource::parseSignal(const std::string &description) {
+    std::vector<std::string> fields = split(description, ':');
+    const std::string &type = fields[0];
+    Signal signal = {Signal::Type::Tone, 0, 0, 0, 0, 0, 0, ""};
+
+    if (type == "tone" && fields.size() == 2) {
+        signal.type = Signal::Type::Tone;
+        signal.frequency = std::stod(fields[1]);
+    } else if (type == "comb" && fields.size() == 4) {
+        signal.type = Signal::Type::Comb;
+        signal.frequency = std::stod(fields[1]);
+        signal.combSpacing = std::stod(fields[2]);
+        signal.combCount = parseCount(fields[3]);
+    } else if ((type == "chirp" || type == "logchirp") && fields.size() == 4) {
+        signal.type = (type == "chirp") ? Signal::Type::Chirp : Signal::Type::LogChirp;
+        signal.frequency = std::stod(fields[1]);
+        signal.frequencyEnd = std::stod(fields[2]);
+        signal.period = std::stod(fields[3]);
+    } else if (type == "noise" && fields.size() == 1) {
+        signal.type = Signal::Type::WhiteNoise;
+    } else if (type == "pink" && fields.size() == 1) {
+        signal.type = Signal::Type::PinkNoise;
+    } else if (type == "cw" && (fields.size() == 3 || fields.size() == 4)) {
+        signal.type = Signal::Type::Cw;
+        signal.frequency = std::stod(fields[1]);
+        signal.wpm = std::stod(fields[2]);
+        signal.message = (fields.size() == 4) ? fields[3] : "CQ TEST";
+    } else {
+        throw std::invalid_argument("Unknown signal " + description);
+    }
+
+    return signal;
+}
+
+/* Morse code of letters and digits */
+static const std::map<char, std::string> MorseCode = {
+    {'A', ".-"}, {'B', "-..."}, {'C', "-.-."}, {'D', "-.."}, {'E', "."}, {'F', "..-."}, {'G', "--."}, {'H', "...."}, {'I', ".."}, {'J', ".---"}, {'K', "-.-"}, {'L', ".-.."}, {'M', "--"}, {'N', "-."}, {'O', "---"}, {'P', ".--."}, {'Q', "--.-"}, {'R', ".-."}, {'S', "..."}, {'T', "-"}, {'U', "..-"}, {'V', "...-"}, {'W', ".--"}, {'X', "-..-"}, {'Y', "-.--"}, {'Z', "--.."}, {'0', "-----"}, {'1', ".----"}, {'2', "..---"}, {'3', "...--"}, {'4', "....-"}, {'5', "....."}, {'6', "-...."}, {'7', "--..."}, {'8', "---.."}, {'9', "----."}};
+
+/* Key down/up per unit: a dot is one unit, a dash three, with one unit
+ * between symbols, three between letters and seven between words */
+static std::vector<bool> morseKeying(const std::string &message) {
+    std::vector<bool> keying;
+
+    for (char c : message) {
+        if (c == ' ') {
+            keying.insert(keying.end(), 4, false);
+            continue;
+        }
+
+        auto code = MorseCode.find(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+        if (code == MorseCode.end())
+            continue;
+
+        for (char symbol : code->second) {
+            keying.insert(keying.end(), (symbol == '.') ? 1 : 3, true);
+            keying.push_back(false);
+        }
+        keying.insert(keying.end(), 2, false);
+    }
+
+    /* Word gap before the message repeats */
+    keying.insert(keying.end(), 4, false);
+
+    return keying;
+}
+
+GeneratorAudioSource::GeneratorAudioSource(const Signal &signal, unsigned int sampleRate, uint64_t frames) : signal(signal), sampleRate(sampleRate), remaining(frames), endless(frames == 0), block(BlockSize), blockOffset(BlockSize), amplitude(Amplitude), omegaStart(0), omegaEnd(0), logRatio(1), sweepLength(0), sweepPosition(0), noiseState(0x9e3779b97f4a7c15ULL), pink(), unitLength(0), edgeLength(0), keyingPosition(0) {
+    const double nyquist = sampleRate / 2.0;
+    const double radiansPerHz = 2 * M_PI / sampleRate;
+
+    if (sampleRate == 0)
+        throw OpenException("Error opening signal generator: sample rate must be above 0.");
+
+    switch (signal.type) {
+    case Signal::Type::Tone:
+    case Signal::Type::Cw:
+        if (signal.frequency < 0 || signal.frequency >= nyquist)
+            throw OpenException("Error opening signal generator: frequency must be below the Nyquist frequency.");
+        oscillators.resize(1);
+        oscillators[0].set(0, signal.frequency * radiansPerHz, 0);
+
+        if (signal.type == Signal::Type::Cw) {
+            if (signal.wpm <= 0)
+                throw OpenException("Error opening signal generator: CW speed must be above 0.");
+            keying = morseKeying(signal.message);
+            /* A dot of the standard word PARIS */
+            unitLength = std::max<uint64_t>(static_cast<uint64_t>(1.2 / signal.wpm * sampleRate), 4);
+            edgeLength = static_cast<size_t>(std::max<uint64_t>(std::min(static_cast<uint64_t>(EdgeSeconds * sampleRate), unitLength / 4), 1));
+        }
+        break;
+    case Signal::Type::Comb: {
+        unsigned int count = signal.combCount;
+        if (count < 1 || count > 1024)
+            throw OpenException("Error opening signal generator: comb must have 1 to 1024 tones.");
+        if (signal.frequency < 0 || signal.combSpacing <= 0 || signal.frequency + (count - 1) * signal.combSpacing >= nyquist)
+            throw OpenException("Error opening signal generator: comb tones must be below the Nyquist frequency.");
+
+        /* Schroeder phases keep the peak of the sum low */
+        oscillators.resize(count);
+        for (unsigned int k = 0; k < count; k++)
+            oscillators[k].set(M_PI * k * k / count, (signal.frequency + k * signal.combSpacing) * radiansPerHz, 0);
+        amplitude = Amplitude / std::sqrt(static_cast<double>(count));
+        break;
+    }
+    case Signal::Type::Chirp:
+    case Signal::Type::LogChirp:
+        if (signal.frequency < 0 || signal.frequency >= nyquist || signal.frequencyEnd < 0 || signal.frequencyEnd >= nyquist)
+            throw OpenException("Error opening signal generator: chirp frequencies must be below the Nyquist frequency.");
+        if (signal.type == Signal::Type::LogChirp && (signal.frequency <= 0 || signal.frequencyEnd <= 0))
+            throw OpenException("Error opening signal generator: logarithmic chirp frequencies must be above 0.");
+        if (signal.period <= 0)
+            throw OpenException("Error opening signal generator: chirp period must be above 0.");
+
+        oscillators.resize(1);
+        omegaStart = signal.frequency * radiansPerHz;
+        omegaEnd = signal.frequencyEnd * radiansPerHz;
+        /* A multiple of four, so segments stay aligned to the lanes */
+        sweepLength = std::max<uint64_t>((static_cast<uint64_t>(signal.period * sampleRate) + 3) & ~static_cast<uint64_t>(3), 4);
+        logRatio = std::pow(omegaEnd / omegaStart, 1.0 / static_cast<double>(sweepLength));
+        oscillators[0].set(0, omegaStart, 0);
+        break;
+    case Signal::Type::WhiteNoise:
+    case Signal::Type::PinkNoise:
+        break;
+    }
+}
+
+void GeneratorAudioSource::Oscillator::set(double phase, double omega, double alpha) {
+    for (unsigned int l = 0; l < 4; l++) {
+        double lanePhase = phase + omega * l + 0.5 * alpha * l * l;
+        /* Phase advance over the lane's next four samples */
+        double laneRotation = 4 * (omega + alpha * l) + 8 * alpha;
+        re[l] = std::cos(lanePhase);
+        im[l] = std::sin(lanePhase);
+        rotationRe[l] = std::cos(laneRotation);
+        rotationIm[l] = std::sin(laneRotation);
+    }
+    stepRe = std::cos(16 * alpha);
+    stepIm = std::sin(16 * alpha);
+}
+
+double GeneratorAudioSource::Oscillator::phase() const {
+    return std::atan2(im[0], re[0]);
+}
+
+void GeneratorAudioSource::Oscillator::generate(double *output, size_t count, double amplitude) {
+    /* Independent lanes, so the compiler can vectorize across them */
+    for (size_t i = 0; i < count; i += 4) {
+        for (unsigned int l = 0; l < 4; l++) {
+            output[i + l] += amplitude * im[l];
+
+            double r = re[l] * rotationRe[l] - im[l] * rotationIm[l];
+            double m = re[l] * rotationIm[l] + im[l] * rotationRe[l];
+            re[l] = r;
+            im[l] = m;
+
+            double rr = rotationRe[l] * stepRe - rotationIm[l] * stepIm;
+            double rm = rotationRe[l] * stepIm + rotationIm[l] * stepRe;
+            rotationRe[l] = rr;
+            rotationIm[l] = rm;
+        }
+    }
+}
+
+void GeneratorAudioSource::Oscillator::normalize() {
+    for (unsigned int l = 0; l < 4; l++) {
+        /* First order correction, the magnitude is close to 1 */
+        double g = (3 - (re[l] * re[l] + im[l] * im[l])) / 2;
+        re[l] *= g;
+        im[l] *= g;
+        g = (3 - (rotationRe[l] * rotationRe[l] + rotationIm[l] * rotationIm[l])) / 2;
+        rotationRe[l] *= g;
+        rotationIm[l] *= g;
+    }
+}
+
+double GeneratorAudioSource::random() {
+    /* xorshift64* */
+    noiseState ^= noiseState >> 12;
+    noiseState ^= noiseState << 25;
+    noiseState ^= noiseState >> 27;
+    return static_cast<double>((noiseState * 0x2545f4914f6cdd1dULL) >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+void GeneratorAudioSource::generateChirp() {
+    Oscillator &oscillator = oscillators[0];
+
+    for (size_t i = 0; i < BlockSize;) {
+        if (sweepPosition == sweepLength)
+            sweepPosition = 0;
+
+        size_t length = static_cast<size_t>(std::min<uint64_t>({SegmentLength, sweepLength - sweepPosition, BlockSize - i}));
+
+        /* Frequency at the start of the segment, changing linearly over it */
+        double omega, alpha;
+        if (signal.type == Signal::Type::Chirp) {
+            omega = omegaStart + (omegaEnd - omegaStart) * static_cast<double>(sweepPosition) / static_cast<double>(sweepLength);
+            alpha = (omegaEnd - omegaStart) / static_cast<double>(sweepLength);
+        } else {
+            /* Slope that advances the phase as much as the exponential sweep does over the segment */
+            double L = static_cast<double>(length);
+            omega = omegaStart * std::pow(logRatio, static_cast<double>(sweepPosition));
+            double advance = (logRatio == 1) ? omega * L : omega * (std::pow(logRatio, L) - 1) / (logRatio - 1);
+            alpha = (advance - omega * L) / (L * L / 2);
+        }
+
+        oscillator.set(oscillator.phase(), omega, alpha);
+        oscillator.generate(block.data() + i, length, amplitude);
+
+        sweepPosition += length;
+        i += length;
+    }
+}
+
+void GeneratorAudioSource::generateNoise() {
+    if (signal.type == Signal::Type::WhiteNoise) {
+        for (size_t i = 0; i < BlockSize; i++)
+            block[i] = Amplitude * random();
+        return;
+    }
+
+    /* Paul Kellet's pink noise filter */
+    for (size_t i = 0; i < BlockSize; i++) {
+        double white = random();
+        pink[0] = 0.99886 * pink[0] + white * 0.0555179;
+        pink[1] = 0.99332 * pink[1] + white * 0.0750759;
+        pink[2] = 0.96900 * pink[2] + white * 0.1538520;
+        pink[3] = 0.86650 * pink[3] + white * 0.3104856;
+        pink[4] = 0.55000 * pink[4] + white * 0.5329522;
+        pink[5] = -0.7616 * pink[5] - white * 0.0168980;
+        double sum = pink[0] + pink[1] + pink[2] + pink[3] + pink[4] + pink[5] + pink[6] + white * 0.5362;
+        pink[6] = white * 0.115926;
+        block[i] = Amplitude * 0.11 * sum;
+    }
+}
+
+void GeneratorAudioSource::applyKeying() {
+    const uint64_t units = keying.size();
+
+    for (size_t i = 0; i < BlockSize; i++, keyingPosition++) {
+        uint64_t unit = (keyingPosition / unitLength) % units;
+        uint64_t offset = keyingPosition % unitLength;
+
+        if (!keying[unit]) {
+            block[i] = 0;
+            continue;
+        }
+
+        /* Raised cosine edges inside the first and last key down units */
+        bool rising = !keying[(unit + units - 1) % units] && offset < edgeLength;
+        bool falling = !keying[(unit + 1) % units] && offset >= unitLength - edgeLength;
+        if (rising)
+            block[i] *= 0.5 - 0.5 * std::cos(M_PI * static_cast<double>(offset) / static_cast<double>(edgeLength));
+        else if (falling)
+            block[i] *= 0.5 - 0.5 * std::cos(M_PI * static_cast<double>(unitLength - offset) / static_cast<double>(edgeLength));
+    }
+}
+
+void GeneratorAudioSource::generate() {
+    switch (signal.type) {
+    case Signal::Type::Tone:
+    case Signal::Type::Comb:
+    case Signal::Type::Cw:
+        std::fill(block.begin(), block.end(), 0.0);
+        for (auto &oscillator : oscillators) {
+            oscillator.generate(block.data(), BlockSize, amplitude);
+            oscillator.normalize();
+        }
+        if (signal.type == Signal::Type::Cw)
+            applyKeying();
+        break;
+    case Signal::Type::Chirp:
+    case Signal::Type::LogChirp:
+        std::fill(block.begin(), block.end(), 0.0);
+        generateChirp();
+        break;
+    case Signal::Type::WhiteNoise:
+    case Signal::Type::PinkNoise:
+        generateNoise();
+        break;
+    }
+
+    blockOffset = 0;
+}
+
+size_t GeneratorAudioSource::read(double *samples, size_t count) {
+    if (!endless)
+        count = static_cast<size_t>(std::min<uint64_t>(count, remaining));
+
+    for (size_t n = 0; n < count;) {
+        if (blockOffset == BlockSize)
+            generate();
+
+        size_t length = std::min(count - n, BlockSize - blockOffset);
+        std::copy(block.begin() + static_cast<std::ptrdiff_t>(blockOffset), block.begin() + static_cast<std::ptrdiff_t>(blockOffset + length), samples + n);
+        blockOffset += length;
+        n += length;
+    }
+
+    if (!endless)
+        remaining -= count;
+
+    return count;
+}
+
+unsigned int GeneratorAudioSource::getSampleRate() {
+    return sampleRate;
+}
+}
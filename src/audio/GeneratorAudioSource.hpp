@@ -0,0 +1,113 @@
+#ifndef _GENERATORAUDIOSOURCE_HPP
+#define _GENERATORAUDIOSOURCE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "AudioSource.hpp"
+
+namespace Audio {
+
+/* Synthetic signal source, for reproducible input without a device or file:
+ * a tone, a comb of tones, a linear or logarithmic chirp, white or pink
+ * noise, or a keyed CW message. Signals are generated a block at a time, by
+ * oscillators running four phasor lanes side by side, so generation keeps
+ * up with MHz sample rates. */
+class GeneratorAudioSource : public AudioSource {
+  public:
+    struct Signal {
+        enum class Type { Tone,
+                          Comb,
+                          Chirp,
+                          LogChirp,
+                          WhiteNoise,
+                          PinkNoise,
+                          Cw };
+
+        Type type;
+        /* Tone, first comb tone and chirp start frequency in Hz */
+        double frequency;
+        /* Chirp end frequency in Hz */
+        double frequencyEnd;
+        /* Chirp period in seconds */
+        double period;
+        /* Comb tone count, and tone spacing in Hz */
+        unsigned int combCount;
+        double combSpacing;
+        /* CW speed in words per minute, and message */
+        double wpm;
+        std::string message;
+    };
+
+    /* Parse a signal description, one of tone:<Hz>, comb:<Hz>:<spacing Hz>:<count>,
+     * chirp:<start Hz>:<end Hz>:<seconds>, logchirp:<start Hz>:<end Hz>:<seconds>,
+     * noise, pink, cw:<Hz>:<wpm>[:<message>], with a whole comb tone count.
+     * Throws std::invalid_argument. */
+    static Signal parseSignal(const std::string &description);
+
+    /* Generates frames frames, or without end with 0 */
+    GeneratorAudioSource(const Signal &signal, unsigned int sampleRate, uint64_t frames = 0);
+    virtual size_t read(double *samples, size_t count);
+    virtual unsigned int getSampleRate();
+
+  private:
+    /* Complex oscillator of four lanes, for samples n to n + 3, with a
+     * linearly changing frequency. Each lane's phasor turns by its rotation
+     * every four samples, and the rotation by a fixed step. */
+    struct Oscillator {
+        double re[4], im[4];
+        double rotationRe[4], rotationIm[4];
+        double stepRe, stepIm;
+
+        /* Set phase and angular frequency (radians per sample) at the next
+         * sample, and frequency change per sample */
+        void set(double phase, double omega, double alpha);
+        /* Phase at the next sample */
+        double phase() const;
+        /* Add amplitude * sine of count samples (a multiple of four) to output */
+        void generate(double *output, size_t count, double amplitude);
+        /* Pull phasors back to unit magnitude */
+        void normalize();
+    };
+
+    /* Fill the block with the next samples of the signal */
+    void generate();
+    void generateChirp();
+    void generateNoise();
+    void applyKeying();
+    /* Next uniform random number in [-1, 1) */
+    double random();
+
+    const Signal signal;
+    const unsigned int sampleRate;
+    uint64_t remaining;
+    const bool endless;
+
+    /* Generated block, read from blockOffset */
+    std::vector<double> block;
+    size_t blockOffset;
+
+    std::vector<Oscillator> oscillators;
+    double amplitude;
+
+    /* Chirp angular frequency bounds, frequency ratio per sample for
+     * logarithmic chirps, and samples into the current sweep */
+    double omegaStart, omegaEnd;
+    double logRatio;
+    uint64_t sweepLength, sweepPosition;
+
+    /* Noise generator state, and pink noise filter state */
+    uint64_t noiseState;
+    double pink[7];
+
+    /* CW keying per unit (dot length), raised cosine edge length in samples,
+     * and position in samples into the keying */
+    std::vector<bool> keying;
+    uint64_t unitLength;
+    size_t edgeLength;
+    uint64_t keyingPosition;
+};
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include <algorithm>
+
+#include "HistoryAudioSource.hpp"
+
+namespace Audio {
+
+HistoryAudioSource::HistoryAudioSource(Pipeline::SampleHistory &history, unsigned int sampleRate, uint64_t position, uint64_t frames) : history(history), sampleRate(sampleRate), position(position), remaining(frames) {}
+
+size_t HistoryAudioSource::read(double *samples, size_t count) {
+    count = static_cast<size_t>(std::min<uint64_t>(count, remaining));
+
+    history.read(samples, position, count);
+    position += count;
+    remaining -= count;
+
+    return count;
+}
+
+unsigned int HistoryAudioSource::getSampleRate() {
+    return sampleRate;
+}
+
+unsigned int HistoryAudioSource::getChannels() {
+    return history.getChannels();
+}
+}
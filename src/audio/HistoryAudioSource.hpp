@@ -0,0 +1,29 @@
+#ifndef _HISTORYAUDIOSOURCE_HPP
+#define _HISTORYAUDIOSOURCE_HPP
+
+#include <cstdint>
+
+#include "AudioSource.hpp"
+#include "pipeline/SampleHistory.hpp"
+
+namespace Audio {
+
+/* Reads a region of a sample history back, from a stream position for a
+ * number of frames, while the history is still being written. Frames the
+ * history no longer holds read as silence. */
+class HistoryAudioSource : public AudioSource {
+  public:
+    HistoryAudioSource(Pipeline::SampleHistory &history, unsigned int sampleRate, uint64_t position, uint64_t frames);
+    virtual size_t read(double *samples, size_t count);
+    virtual unsigned int getSampleRate();
+    virtual unsigned int getChannels();
+
+  private:
+    Pipeline::SampleHistory &history;
+    const unsigned int sampleRate;
+    uint64_t position;
+    uint64_t remaining;
+};
+}
+
+#endif
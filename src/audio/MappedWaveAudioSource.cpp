@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "MappedWaveAudioSource.hpp"
+
+namespace Audio {
+
+/* Pages are read ahead, and dropped behind, in steps of this many bytes */
+static const size_t AdviseStep = 8 * 1024 * 1024;
+
+static uint32_t readLe32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+MappedWaveAudioSource::MappedWaveAudioSource(std::string path) : fd(-1), mapping(nullptr), mappingSize(0), format(), bytesPerFrame(0), data(nullptr), dataFrames(0), position(0), advised(0), dropped(0) {
+    if ((fd = open(path.c_str(), O_RDONLY | O_CLOEXEC)) < 0)
+        throw OpenException("Error opening WAV file: " + std::string(std::strerror(errno)));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw OpenException("Error opening WAV file: " + std::string(std::strerror(errno)));
+    }
+
+    mappingSize = static_cast<size_t>(st.st_size);
+    if (mappingSize < 12) {
+        close(fd);
+        throw FormatException("Error opening WAV file: file too short.");
+    }
+
+    void *addr = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        throw FormatException("Error mapping WAV file: " + std::string(std::strerror(errno)));
+    }
+    mapping = static_cast<const uint8_t *>(addr);
+
+    /* Samples are read front to back, once */
+    madvise(addr, mappingSize, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    /* Best effort, only file systems with huge page support take the hint */
+    madvise(addr, mappingSize, MADV_HUGEPAGE);
+#endif
+
+    try {
+        parseHeader();
+    } catch (const std::exception &) {
+        munmap(addr, mappingSize);
+        close(fd);
+        throw;
+    }
+
+    advise();
+}
+
+MappedWaveAudioSource::~MappedWaveAudioSource() {
+    munmap(const_cast<uint8_t *>(mapping), mappingSize);
+    close(fd);
+}
+
+void MappedWaveAudioSource::parseHeader() {
+    if (std::memcmp(mapping, "RIFF", 4) != 0 || std::memcmp(mapping + 8, "WAVE", 4) != 0)
+        throw FormatException("Error opening WAV file: not a RIFF WAVE file.");
+
+    bool haveFormat = false;
+    size_t dataBytes = 0;
+
+    /* Walk the chunks up to the data chunk, chunks are padded to even sizes */
+    size_t offset = 12;
+    while (offset + 8 <= mappingSize) {
+        const uint8_t *chunk = mapping + offset;
+        size_t chunkSize = readLe32(chunk + 4);
+        offset += 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (offset + chunkSize > mappingSize)
+                throw FormatException("Error opening WAV file: invalid format chunk.");
+
+            format = parseWaveFormat(mapping + offset, chunkSize);
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat)
+                throw FormatException("Error opening WAV file: data chunk before format chunk.");
+
+            /* Streamed writers leave the size unset or at its maximum, take the rest of the file */
+            dataBytes = (chunkSize == 0 || chunkSize > mappingSize - offset) ? mappingSize - offset : chunkSize;
+            data = mapping + offset;
+            break;
+        }
+
+        offset += chunkSize + (chunkSize & 1);
+    }
+
+    if (data == nullptr)
+        throw FormatException("Error opening WAV file: no data chunk.");
+
+    bytesPerFrame = format.channels * sampleBytes(format.sampleFormat);
+    dataFrames = dataBytes / bytesPerFrame;
+}
+
+void MappedWaveAudioSource::advise() {
+    size_t offset = static_cast<size_t>(data - mapping) + position * bytesPerFrame;
+    if (offset + AdviseStep / 2 < advised)
+        return;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    size_t pageMask = ~(static_cast<size_t>(pageSize) - 1);
+    uint8_t *base = const_cast<uint8_t *>(mapping);
+
+    /* Drop the pages we're done with, so multi-gigabyte files don't crowd out
+     * the page cache */
+    size_t behind = offset & pageMask;
+    if (behind > dropped) {
+        madvise(base + dropped, behind - dropped, MADV_DONTNEED);
+        posix_fadvise(fd, static_cast<off_t>(dropped), static_cast<off_t>(behind - dropped), POSIX_FADV_DONTNEED);
+        dropped = behind;
+    }
+
+    /* Read the next step ahead */
+    size_t start = advised & pageMask;
+    size_t end = std::min(offset + AdviseStep, mappingSize);
+    if (end > start)
+        madvise(base + start, end - start, MADV_WILLNEED);
+    advised = end;
+}
+
+uint64_t MappedWaveAudioSource::getFrames() {
+    return dataFrames;
+}
+
+bool MappedWaveAudioSource::seek(uint64_t frame) {
+    position = static_cast<size_t>(std::min<uint64_t>(frame, dataFrames));
+
+    /* Read ahead from the new position, without touching the pages skipped */
+    size_t offset = static_cast<size_t>(data - mapping) + position * bytesPerFrame;
+    dropped = std::max(dropped, offset & ~(static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1));
+    advised = offset;
+    advise();
+
+    return true;
+}
+
+size_t MappedWaveAudioSource::read(double *samples, size_t count) {
+    count = std::min(count, dataFrames - position);
+
+    convertSamples(format.sampleFormat, data + position * bytesPerFrame, count * format.channels, samples);
+
+    position += count;
+    advise();
+
+    /* Short read at end of file */
+    return count;
+}
+
+unsigned int MappedWaveAudioSource::getSampleRate() {
+    return format.sampleRate;
+}
+
+unsigned int MappedWaveAudioSource::getChannels() {
+    return format.channels;
+}
+}
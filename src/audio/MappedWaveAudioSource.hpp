@@ -0,0 +1,51 @@
+#ifndef _MAPPEDWAVEAUDIOSOURCE_HPP
+#define _MAPPEDWAVEAUDIOSOURCE_HPP
+
+#include <string>
+#include <cstdint>
+
+#include "AudioSource.hpp"
+#include "SampleFormat.hpp"
+
+namespace Audio {
+
+/* Uncompressed PCM16, PCM24, PCM32 and 32-bit float WAV file source. The file is
+ * memory mapped and its RIFF header parsed here, and samples are converted
+ * straight from the mapped pages, without libsndfile's intermediate buffers.
+ * Other formats throw FormatException, for a fall back to WaveAudioSource. */
+class MappedWaveAudioSource : public AudioSource {
+  public:
+    MappedWaveAudioSource(std::string path);
+    ~MappedWaveAudioSource();
+    virtual size_t read(double *samples, size_t count);
+    virtual uint64_t getFrames();
+    virtual bool seek(uint64_t frame);
+    virtual unsigned int getSampleRate();
+    virtual unsigned int getChannels();
+
+  private:
+    void parseHeader();
+    /* Read ahead of, and drop pages behind, the read position */
+    void advise();
+
+    /* Mapped file */
+    int fd;
+    const uint8_t *mapping;
+    size_t mappingSize;
+
+    /* Format */
+    WaveFormat format;
+    size_t bytesPerFrame;
+
+    /* Data chunk and read position in frames */
+    const uint8_t *data;
+    size_t dataFrames;
+    size_t position;
+
+    /* Mapping offsets read ahead up to, and dropped up to */
+    size_t advised;
+    size_t dropped;
+};
+}
+
+#endif
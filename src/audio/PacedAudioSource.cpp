@@ -0,0 +1,77 @@
+#include <thread>
+
+#include "PacedAudioSource.hpp"
+
+namespace Audio {
+
+/* Lateness a capture device would buffer before overrunning */
+static const std::chrono::milliseconds DeviceBuffer(20);
+
+PacedAudioSource::PacedAudioSource(std::function<std::unique_ptr<AudioSource>()> open, double speed, bool loop) : open(open), source(open()), speed(speed), loop(loop), sampleRate(source->getSampleRate()), channels(source->getChannels()), position(0), behind(false), overflows(0), latencyMicroseconds(0) {}
+
+std::chrono::steady_clock::time_point PacedAudioSource::due(uint64_t frame) {
+    return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(frame) / (static_cast<double>(sampleRate) * speed)));
+}
+
+size_t PacedAudioSource::read(double *samples, size_t count) {
+    size_t n = source->read(samples, count);
+
+    /* Start over at the end of the source, if looping */
+    if (n == 0 && loop) {
+        source = open();
+        if (source->getSampleRate() != sampleRate || source->getChannels() != channels)
+            throw ReadException("Error looping audio source: format changed.");
+        n = source->read(samples, count);
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (position == 0)
+        start = now;
+
+    if (speed <= 0) {
+        readTimestamp = now;
+        position += n;
+        return n;
+    }
+
+    /* Hold the frames until the last of them is due */
+    readTimestamp = due(position);
+    position += n;
+    std::chrono::steady_clock::time_point deadline = due(position);
+
+    if (now < deadline) {
+        std::this_thread::sleep_until(deadline);
+        latencyMicroseconds = 0;
+        behind = false;
+    } else {
+        std::chrono::steady_clock::duration late = now - deadline;
+        latencyMicroseconds = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::microseconds>(late).count());
+        if (late > DeviceBuffer && !behind) {
+            overflows++;
+            behind = true;
+        }
+    }
+
+    return n;
+}
+
+unsigned int PacedAudioSource::getSampleRate() {
+    return sampleRate;
+}
+
+unsigned int PacedAudioSource::getChannels() {
+    return channels;
+}
+
+std::chrono::steady_clock::time_point PacedAudioSource::getReadTimestamp() {
+    return readTimestamp;
+}
+
+size_t PacedAudioSource::getDebugOverflows() {
+    return overflows;
+}
+
+unsigned int PacedAudioSource::getDebugLatency() {
+    return latencyMicroseconds / 1000;
+}
+}
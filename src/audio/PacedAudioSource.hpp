@@ -0,0 +1,56 @@
+#ifndef _PACEDAUDIOSOURCE_HPP
+#define _PACEDAUDIOSOURCE_HPP
+
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <atomic>
+
+#include "AudioSource.hpp"
+
+namespace Audio {
+
+/* Plays back a file source as if it were captured live, at its sample rate
+ * times a speed, or as fast as it is read with a speed of 0. Each read
+ * returns once the last of its frames is due, stamped with the time its
+ * first frame was due. With looping, the source is opened again at its end.
+ *
+ * Reads that come due more than a capture device's buffer late are counted
+ * as an overflow, once until playback is back on schedule, and the playback
+ * falls behind rather than skipping. */
+class PacedAudioSource : public AudioSource {
+  public:
+    PacedAudioSource(std::function<std::unique_ptr<AudioSource>()> open, double speed, bool loop);
+    virtual size_t read(double *samples, size_t count);
+    virtual unsigned int getSampleRate();
+    virtual unsigned int getChannels();
+    virtual std::chrono::steady_clock::time_point getReadTimestamp();
+
+    virtual size_t getDebugOverflows();
+    virtual unsigned int getDebugLatency();
+
+  private:
+    /* Time frame position is due */
+    std::chrono::steady_clock::time_point due(uint64_t frame);
+
+    const std::function<std::unique_ptr<AudioSource>()> open;
+    std::unique_ptr<AudioSource> source;
+    const double speed;
+    const bool loop;
+    const unsigned int sampleRate;
+    const unsigned int channels;
+
+    /* Playback start, and frames played since */
+    std::chrono::steady_clock::time_point start;
+    uint64_t position;
+    std::chrono::steady_clock::time_point readTimestamp;
+    /* Behind schedule since the last overflow */
+    bool behind;
+
+    std::atomic<size_t> overflows;
+    /* How far the last read came due behind schedule, in microseconds */
+    std::atomic<unsigned int> latencyMicroseconds;
+};
+}
+
+#endif
@@ -1,51 +1,349 @@
 #include <stdexcept>
-#include <vector>
+#include <algorithm>
 
-#include <pulse/simple.h>
-#include <pulse/error.h>
+#include <pulse/pulseaudio.h>
 
 #include "PulseAudioSource.hpp"
 
 namespace Audio {
 
-PulseAudioSource::PulseAudioSource(unsigned int sampleRate) : sampleRate(sampleRate) {
-    int error;
+/* A second of samples, or a few fragments */
+static size_t ringCapacity(unsigned int sampleRate, unsigned int fragmentSize) {
+    return std::max<size_t>(sampleRate, 4 * fragmentSize);
+}
+
+PulseAudioSource::Capture::Capture(unsigned int sampleRate, size_t capacity) : stream(nullptr), sampleRate(sampleRate), ring(capacity), timing(256), writePosition(0), readPosition(0), readTiming(), nextTiming(), nextTimingValid(false) {}
+
+PulseAudioSource::PulseAudioSource(unsigned int sampleRate, unsigned int fragmentSize, unsigned int latency, const std::string &device) : mainloop(nullptr), context(nullptr), fragmentSize(fragmentSize), latency(latency), device(device), reading(new Capture(sampleRate, ringCapacity(sampleRate, fragmentSize))), sampleRate(sampleRate), recording(reading.get()), next(nullptr), switching(false), failed(false), overflows(0), underflows(0), samplesLost(0), latencyMicroseconds(0) {
+    if ((mainloop = pa_threaded_mainloop_new()) == nullptr)
+        throw OpenException("Opening PulseAudio: pa_threaded_mainloop_new(): failed");
+
+    if ((context = pa_context_new(pa_threaded_mainloop_get_api(mainloop), "audioprism")) == nullptr) {
+        close();
+        throw OpenException("Opening PulseAudio: pa_context_new(): failed");
+    }
+    pa_context_set_state_callback(context, contextStateCallback, this);
+
+    pa_threaded_mainloop_lock(mainloop);
+
+    if (pa_context_connect(context, nullptr, PA_CONTEXT_NOFLAGS, nullptr) < 0 || pa_threaded_mainloop_start(mainloop) < 0) {
+        std::string error = pa_strerror(pa_context_errno(context));
+        pa_threaded_mainloop_unlock(mainloop);
+        close();
+        throw OpenException("Opening PulseAudio: pa_context_connect(): " + error);
+    }
+
+    /* Wait for the context to connect */
+    pa_context_state_t contextState;
+    while ((contextState = pa_context_get_state(context)) != PA_CONTEXT_READY) {
+        if (!PA_CONTEXT_IS_GOOD(contextState)) {
+            std::string error = pa_strerror(pa_context_errno(context));
+            pa_threaded_mainloop_unlock(mainloop);
+            close();
+            throw OpenException("Opening PulseAudio: connecting context: " + error);
+        }
+        pa_threaded_mainloop_wait(mainloop);
+    }
+
+    std::string error = connect(*reading);
+    if (!error.empty()) {
+        pa_threaded_mainloop_unlock(mainloop);
+        close();
+        throw OpenException("Opening PulseAudio: " + error);
+    }
+
+    /* Wait for the stream to start */
+    pa_stream_state_t streamState;
+    while ((streamState = pa_stream_get_state(reading->stream)) != PA_STREAM_READY) {
+        if (!PA_STREAM_IS_GOOD(streamState)) {
+            std::string error = pa_strerror(pa_context_errno(context));
+            pa_threaded_mainloop_unlock(mainloop);
+            close();
+            throw OpenException("Opening PulseAudio: connecting stream" + (device.empty() ? std::string() : " to " + device) + ": " + error);
+        }
+        pa_threaded_mainloop_wait(mainloop);
+    }
+
+    pa_threaded_mainloop_unlock(mainloop);
+}
+
+PulseAudioSource::~PulseAudioSource() {
+    close();
+}
+
+std::string PulseAudioSource::connect(Capture &capture) {
     pa_sample_spec ss;
     pa_buffer_attr attr;
 
     ss.format = PA_SAMPLE_FLOAT32LE;
-    ss.rate = sampleRate;
+    ss.rate = capture.sampleRate;
     ss.channels = 1;
 
+    /* For record streams with adjusted latency, the fragment size is the target latency */
     attr.maxlength = -1u;
     attr.tlength = -1u;
     attr.prebuf = -1u;
     attr.minreq = -1u;
-    attr.fragsize = 1024;
+    attr.fragsize = (latency > 0) ? static_cast<uint32_t>(pa_usec_to_bytes(static_cast<pa_usec_t>(latency) * 1000, &ss)) : static_cast<uint32_t>(fragmentSize * sizeof(float));
+
+    if ((capture.stream = pa_stream_new(context, "audio in", &ss, nullptr)) == nullptr)
+        return "pa_stream_new(): " + std::string(pa_strerror(pa_context_errno(context)));
+    pa_stream_set_state_callback(capture.stream, streamStateCallback, this);
+    pa_stream_set_read_callback(capture.stream, streamReadCallback, this);
+    pa_stream_set_overflow_callback(capture.stream, streamOverflowCallback, this);
+    pa_stream_set_underflow_callback(capture.stream, streamUnderflowCallback, this);
 
-    s = pa_simple_new(nullptr, "spectrogram", PA_STREAM_RECORD, nullptr, "audio in", &ss, nullptr, &attr, &error);
-    if (s == nullptr)
-        throw OpenException("Opening PulseAudio: pa_simple_new(): " + std::string(pa_strerror(error)));
+    pa_stream_flags_t flags = static_cast<pa_stream_flags_t>(PA_STREAM_ADJUST_LATENCY | PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE);
+    if (pa_stream_connect_record(capture.stream, device.empty() ? nullptr : device.c_str(), &attr, flags) < 0) {
+        std::string error = pa_strerror(pa_context_errno(context));
+        disconnect(capture);
+        return "pa_stream_connect_record(): " + error;
+    }
+
+    return "";
 }
 
-PulseAudioSource::~PulseAudioSource() {
-    if (s)
-        pa_simple_free(s);
+void PulseAudioSource::disconnect(Capture &capture) {
+    if (capture.stream == nullptr)
+        return;
+
+    /* No more callbacks for this stream */
+    pa_stream_set_state_callback(capture.stream, nullptr, nullptr);
+    pa_stream_set_read_callback(capture.stream, nullptr, nullptr);
+    pa_stream_set_overflow_callback(capture.stream, nullptr, nullptr);
+    pa_stream_set_underflow_callback(capture.stream, nullptr, nullptr);
+    pa_stream_disconnect(capture.stream);
+    pa_stream_unref(capture.stream);
+    capture.stream = nullptr;
+}
+
+void PulseAudioSource::close() {
+    /* Stop the mainloop first, so no callback runs during teardown */
+    if (mainloop)
+        pa_threaded_mainloop_stop(mainloop);
+
+    /* Streams of the capture read, and of a switch under way */
+    std::unique_ptr<Capture> handed(next.exchange(nullptr));
+    for (Capture *capture : {reading.get(), pending.get(), handed.get()}) {
+        if (capture)
+            disconnect(*capture);
+    }
+
+    if (context) {
+        pa_context_disconnect(context);
+        pa_context_unref(context);
+        context = nullptr;
+    }
+
+    if (mainloop) {
+        pa_threaded_mainloop_free(mainloop);
+        mainloop = nullptr;
+    }
+}
+
+void PulseAudioSource::contextStateCallback(pa_context *context, void *userdata) {
+    (void)context;
+    PulseAudioSource *self = static_cast<PulseAudioSource *>(userdata);
+    pa_threaded_mainloop_signal(self->mainloop, 0);
+}
+
+void PulseAudioSource::streamStateCallback(pa_stream *stream, void *userdata) {
+    PulseAudioSource *self = static_cast<PulseAudioSource *>(userdata);
+    if (!PA_STREAM_IS_GOOD(pa_stream_get_state(stream))) {
+        if (self->pending && stream == self->pending->stream) {
+            /* The new sample rate failed, keep recording at the old one */
+            self->disconnect(*self->pending);
+            self->pending.reset();
+            self->switching = false;
+        } else {
+            self->failed = true;
+        }
+    }
+    pa_threaded_mainloop_signal(self->mainloop, 0);
 }
 
-void PulseAudioSource::read(std::vector<double> &samples) {
-    size_t count = samples.size();
-    std::vector<float> fsamples(count);
-    int error;
+void PulseAudioSource::streamReadCallback(pa_stream *stream, size_t nbytes, void *userdata) {
+    (void)nbytes;
+    PulseAudioSource *self = static_cast<PulseAudioSource *>(userdata);
+
+    if (self->pending && stream == self->pending->stream) {
+        /* First samples at the new sample rate: take the old stream's last
+         * fragments, stop it, and hand the new capture to the reader */
+        self->onRead(*self->recording);
+        self->disconnect(*self->recording);
+        self->recording = self->pending.get();
+        self->next.store(self->pending.release(), std::memory_order_release);
+    }
 
-    if (pa_simple_read(s, fsamples.data(), count * sizeof(float), &error) < 0)
-        throw ReadException("Reading PulseAudio: pa_simple_read(): " + std::string(pa_strerror(error)));
+    if (stream == self->recording->stream)
+        self->onRead(*self->recording);
+}
+
+void PulseAudioSource::streamOverflowCallback(pa_stream *stream, void *userdata) {
+    (void)stream;
+    static_cast<PulseAudioSource *>(userdata)->overflows++;
+}
 
-    for (unsigned int i = 0; i < count; i++)
-        samples[i] = static_cast<double>(fsamples[i]);
+void PulseAudioSource::streamUnderflowCallback(pa_stream *stream, void *userdata) {
+    (void)stream;
+    static_cast<PulseAudioSource *>(userdata)->underflows++;
+}
+
+void PulseAudioSource::onRead(Capture &capture) {
+    pa_stream *stream = capture.stream;
+
+    /* Capture time of the first sample about to be peeked: the stream
+     * latency is how long ago it was recorded */
+    pa_usec_t latency = 0;
+    int negative = 0;
+    bool timed = pa_stream_get_latency(stream, &latency, &negative) == 0 && !negative;
+    std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now() - std::chrono::microseconds(timed ? latency : 0);
+
+    if (timed)
+        latencyMicroseconds = static_cast<unsigned int>(latency);
+
+    while (pa_stream_readable_size(stream) > 0) {
+        const void *data;
+        size_t nbytes;
+
+        if (pa_stream_peek(stream, &data, &nbytes) < 0) {
+            failed = true;
+            return;
+        }
+
+        /* Nothing left to read */
+        if (nbytes == 0)
+            break;
+
+        size_t count = nbytes / sizeof(float);
+
+        if (data == nullptr) {
+            /* Hole in the stream: samples the server dropped */
+            samplesLost += count;
+        } else if (capture.ring.write(static_cast<const float *>(data), count)) {
+            /* Timing point for the start of this fragment, dropped if the reader is far behind */
+            if (timed) {
+                TimingPoint point = {capture.writePosition, timestamp};
+                capture.timing.write(&point, 1);
+            }
+            capture.writePosition += count;
+        } else {
+            /* Reader fell behind, ring is full */
+            overflows++;
+            samplesLost += count;
+        }
+
+        /* Next fragment was captured after this one */
+        timestamp += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(count) / capture.sampleRate));
+
+        pa_stream_drop(stream);
+    }
+}
+
+size_t PulseAudioSource::read(double *samples, size_t count) {
+    while (true) {
+        /* Old capture drained: switch to the new one */
+        bool ended = next.load(std::memory_order_acquire) != nullptr;
+        if (ended && reading->ring.empty()) {
+            retired = std::move(reading);
+            reading.reset(next.exchange(nullptr));
+            sampleRate = reading->sampleRate;
+            switching.store(false, std::memory_order_release);
+            ended = false;
+        }
+
+        /* Can't wait for more than the ring holds */
+        count = std::min(count, reading->ring.capacity());
+
+        /* Old capture ended: take what is left of it */
+        if (ended) {
+            count = std::min(count, reading->ring.count());
+            break;
+        }
+
+        /* Wait for count samples, polling in case the stream failed or a
+         * switch ended it */
+        if (reading->ring.waitReadable(count, std::chrono::milliseconds(10)))
+            break;
+        if (failed)
+            throw ReadException("Reading PulseAudio: stream failed");
+    }
+
+    Capture &capture = *reading;
+
+    /* Pick up the latest timing point at or before the first sample */
+    while (true) {
+        if (!capture.nextTimingValid)
+            capture.nextTimingValid = capture.timing.read(&capture.nextTiming, 1) == 1;
+        if (!capture.nextTimingValid || capture.nextTiming.position > capture.readPosition)
+            break;
+        capture.readTiming = capture.nextTiming;
+        capture.nextTimingValid = false;
+    }
+
+    if (capture.readTiming.timestamp != std::chrono::steady_clock::time_point())
+        readTimestamp = capture.readTiming.timestamp + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(capture.readPosition - capture.readTiming.position) / capture.sampleRate));
+
+    /* Convert in small blocks, straight into the caller's buffer */
+    float fsamples[256];
+    for (size_t i = 0; i < count;) {
+        size_t n = capture.ring.read(fsamples, std::min(count - i, sizeof(fsamples) / sizeof(fsamples[0])));
+        for (size_t j = 0; j < n; j++)
+            samples[i + j] = static_cast<double>(fsamples[j]);
+        i += n;
+    }
+
+    capture.readPosition += count;
+
+    return count;
 }
 
 unsigned int PulseAudioSource::getSampleRate() {
     return sampleRate;
 }
+
+bool PulseAudioSource::setSampleRate(unsigned int sampleRate) {
+    /* One switch at a time, the reader is done with the capture retired by the last */
+    if (switching.load(std::memory_order_acquire))
+        return false;
+    if (sampleRate == this->sampleRate)
+        return true;
+
+    retired.reset();
+    std::unique_ptr<Capture> capture(new Capture(sampleRate, ringCapacity(sampleRate, fragmentSize)));
+
+    pa_threaded_mainloop_lock(mainloop);
+    bool connected = connect(*capture).empty();
+    if (connected) {
+        pending = std::move(capture);
+        switching = true;
+    }
+    pa_threaded_mainloop_unlock(mainloop);
+
+    return connected;
+}
+
+bool PulseAudioSource::isSwitchingSampleRate() {
+    return switching.load(std::memory_order_acquire);
+}
+
+std::chrono::steady_clock::time_point PulseAudioSource::getReadTimestamp() {
+    return readTimestamp;
+}
+
+size_t PulseAudioSource::getDebugOverflows() {
+    return overflows;
+}
+
+size_t PulseAudioSource::getDebugUnderflows() {
+    return underflows;
+}
+
+size_t PulseAudioSource::getDebugSamplesLost() {
+    return samplesLost;
+}
+
+unsigned int PulseAudioSource::getDebugLatency() {
+    return latencyMicroseconds / 1000;
+}
 }
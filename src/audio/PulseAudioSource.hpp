@@ -1,22 +1,109 @@
 #ifndef _PULSEAUDIOSOURCE_HPP
 #define _PULSEAUDIOSOURCE_HPP
 
-#include <pulse/simple.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <memory>
+
+#include <pulse/pulseaudio.h>
 
 #include "AudioSource.hpp"
+#include "pipeline/SpscRingBuffer.hpp"
+#include "pipeline/CacheAligned.hpp"
 
 namespace Audio {
 
-class PulseAudioSource : public AudioSource {
+/* PulseAudio record stream on a threaded mainloop. The stream callback
+ * moves each fragment into a lock-free ring as it arrives, with its capture
+ * time, and read() takes samples from the ring. A sample rate change opens
+ * a second stream alongside; once it delivers, the old stream is stopped,
+ * and read() moves on to the new ring when the old one is drained. */
+class PulseAudioSource : public AudioSource, public CacheAligned<PulseAudioSource> {
   public:
-    PulseAudioSource(unsigned int sampleRate);
+    /* Target latency in milliseconds overrides the fragment size, if non-zero.
+     * Records from the named source device, or the default source if empty. */
+    PulseAudioSource(unsigned int sampleRate, unsigned int fragmentSize = 256, unsigned int latency = 0, const std::string &device = "");
     ~PulseAudioSource();
-    virtual void read(std::vector<double> &samples);
+    virtual size_t read(double *samples, size_t count);
     virtual unsigned int getSampleRate();
+    virtual bool setSampleRate(unsigned int sampleRate);
+    virtual bool isSwitchingSampleRate();
+    virtual std::chrono::steady_clock::time_point getReadTimestamp();
+
+    /* Debug Statistics */
+    virtual size_t getDebugOverflows();
+    virtual size_t getDebugUnderflows();
+    virtual size_t getDebugSamplesLost();
+    virtual unsigned int getDebugLatency();
 
   private:
-    pa_simple *s;
-    unsigned int sampleRate;
+    /* Capture time of the sample at a position in the ring */
+    struct TimingPoint {
+        uint64_t position;
+        std::chrono::steady_clock::time_point timestamp;
+    };
+
+    /* Record stream at a sample rate, and its samples and their timing,
+     * from the mainloop thread to the reader */
+    struct Capture : public CacheAligned<Capture> {
+        Capture(unsigned int sampleRate, size_t capacity);
+
+        pa_stream *stream;
+        const unsigned int sampleRate;
+        SpscRingBuffer<float> ring;
+        SpscRingBuffer<TimingPoint> timing;
+        /* Mainloop thread: position of the next sample written to the ring */
+        uint64_t writePosition;
+        /* Reader: position of the next sample read, and the timing points around it */
+        uint64_t readPosition;
+        TimingPoint readTiming;
+        TimingPoint nextTiming;
+        bool nextTimingValid;
+    };
+
+    /* Create and connect the capture's stream, with the mainloop locked,
+     * returns an error message on failure */
+    std::string connect(Capture &capture);
+    void disconnect(Capture &capture);
+    void close();
+
+    /* Mainloop callbacks */
+    static void contextStateCallback(pa_context *context, void *userdata);
+    static void streamStateCallback(pa_stream *stream, void *userdata);
+    static void streamReadCallback(pa_stream *stream, size_t nbytes, void *userdata);
+    static void streamOverflowCallback(pa_stream *stream, void *userdata);
+    static void streamUnderflowCallback(pa_stream *stream, void *userdata);
+    void onRead(Capture &capture);
+
+    pa_threaded_mainloop *mainloop;
+    pa_context *context;
+
+    /* Stream settings, for the streams of later sample rates */
+    const unsigned int fragmentSize;
+    const unsigned int latency;
+    const std::string device;
+
+    /* Reader: capture read from, and the one it last switched from */
+    std::unique_ptr<Capture> reading;
+    std::unique_ptr<Capture> retired;
+    std::atomic<unsigned int> sampleRate;
+    std::chrono::steady_clock::time_point readTimestamp;
+
+    /* Mainloop thread: capture recorded into, and the one connecting at a
+     * new sample rate. Once it delivers, it is handed to the reader in next. */
+    Capture *recording;
+    std::unique_ptr<Capture> pending;
+    std::atomic<Capture *> next;
+    /* Set from a switch request until the reader has switched */
+    std::atomic<bool> switching;
+
+    std::atomic<bool> failed;
+    std::atomic<size_t> overflows;
+    std::atomic<size_t> underflows;
+    std::atomic<size_t> samplesLost;
+    std::atomic<unsigned int> latencyMicroseconds;
 };
 }
 
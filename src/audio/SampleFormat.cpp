@@ -0,0 +1,89 @@
+#include <cstring>
+
+#include "SampleFormat.hpp"
+#include "AudioSource.hpp"
+
+namespace Audio {
+
+static uint16_t readLe16(const uint8_t *p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readLe32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+size_t sampleBytes(SampleFormat format) {
+    switch (format) {
+    case SampleFormat::S16:
+        return 2;
+    case SampleFormat::S24:
+        return 3;
+    case SampleFormat::S32:
+    case SampleFormat::F32:
+        return 4;
+    }
+    return 0;
+}
+
+void convertSamples(SampleFormat format, const uint8_t *input, size_t count, double *output) {
+    switch (format) {
+    case SampleFormat::S16:
+        for (size_t i = 0; i < count; i++)
+            output[i] = static_cast<double>(static_cast<int16_t>(readLe16(input + 2 * i))) * (1.0 / 32768.0);
+        break;
+    case SampleFormat::S24:
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t *p = input + 3 * i;
+            /* Sign extend from the top byte */
+            int32_t value = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 24)) / 256;
+            output[i] = static_cast<double>(value) * (1.0 / 8388608.0);
+        }
+        break;
+    case SampleFormat::S32:
+        for (size_t i = 0; i < count; i++)
+            output[i] = static_cast<double>(static_cast<int32_t>(readLe32(input + 4 * i))) * (1.0 / 2147483648.0);
+        break;
+    case SampleFormat::F32:
+        for (size_t i = 0; i < count; i++) {
+            uint32_t bits = readLe32(input + 4 * i);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            output[i] = static_cast<double>(value);
+        }
+        break;
+    }
+}
+
+WaveFormat parseWaveFormat(const uint8_t *chunk, size_t size) {
+    if (size < 16)
+        throw FormatException("Error opening WAV file: invalid format chunk.");
+
+    uint16_t formatTag = readLe16(chunk);
+    unsigned int channels = readLe16(chunk + 2);
+    unsigned int sampleRate = readLe32(chunk + 4);
+    unsigned int blockAlign = readLe16(chunk + 12);
+    unsigned int bitsPerSample = readLe16(chunk + 14);
+
+    /* WAVE_FORMAT_EXTENSIBLE carries the format tag in its sub-format */
+    if (formatTag == 0xfffe && size >= 40)
+        formatTag = readLe16(chunk + 24);
+
+    SampleFormat sampleFormat;
+    if (formatTag == 1 && bitsPerSample == 16)
+        sampleFormat = SampleFormat::S16;
+    else if (formatTag == 1 && bitsPerSample == 24)
+        sampleFormat = SampleFormat::S24;
+    else if (formatTag == 1 && bitsPerSample == 32)
+        sampleFormat = SampleFormat::S32;
+    else if (formatTag == 3 && bitsPerSample == 32)
+        sampleFormat = SampleFormat::F32;
+    else
+        throw FormatException("Error opening WAV file: unsupported sample format.");
+
+    if (channels == 0 || sampleRate == 0 || blockAlign != channels * sampleBytes(sampleFormat))
+        throw FormatException("Error opening WAV file: invalid format chunk.");
+
+    return {sampleFormat, channels, sampleRate};
+}
+}
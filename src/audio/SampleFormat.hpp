@@ -0,0 +1,33 @@
+#ifndef _SAMPLEFORMAT_HPP
+#define _SAMPLEFORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Audio {
+
+/* Little-endian PCM sample formats read without libsndfile */
+enum class SampleFormat { S16,
+                          S24,
+                          S32,
+                          F32 };
+
+/* Bytes per sample */
+size_t sampleBytes(SampleFormat format);
+
+/* Convert count samples to doubles, normalized as by libsndfile to [-1.0, 1.0) */
+void convertSamples(SampleFormat format, const uint8_t *input, size_t count, double *output);
+
+/* Sample format, channels and sample rate of a WAV file */
+struct WaveFormat {
+    SampleFormat sampleFormat;
+    unsigned int channels;
+    unsigned int sampleRate;
+};
+
+/* Parse the body of a RIFF "fmt " chunk, throws FormatException for
+ * anything but uncompressed PCM16/24/32 and 32-bit float */
+WaveFormat parseWaveFormat(const uint8_t *chunk, size_t size);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "StreamAudioSource.hpp"
+
+namespace Audio {
+
+/* Stream bytes buffered per read */
+static const size_t BufferSize = 1024 * 1024;
+
+static uint32_t readLe32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+StreamAudioSource::StreamAudioSource(std::string path, Format streamFormat, unsigned int sampleRate, unsigned int channels) : fd(-1), format(), bytesPerFrame(0), buffer(BufferSize), bufferStart(0), bufferEnd(0), endOfStream(false), dataRemaining(std::numeric_limits<uint64_t>::max()) {
+    if (path == "-")
+        fd = STDIN_FILENO;
+    else if ((fd = open(path.c_str(), O_RDONLY | O_CLOEXEC)) < 0)
+        throw OpenException("Error opening audio stream: " + std::string(std::strerror(errno)));
+
+    try {
+        if (streamFormat == Format::Wav) {
+            parseHeader();
+        } else {
+            if (sampleRate == 0 || channels == 0)
+                throw FormatException("Error opening audio stream: raw streams need a sample rate and channel count.");
+
+            format.sampleFormat = (streamFormat == Format::S16) ? SampleFormat::S16 : (streamFormat == Format::S32) ? SampleFormat::S32 : SampleFormat::F32;
+            format.channels = channels;
+            format.sampleRate = sampleRate;
+        }
+    } catch (const std::exception &) {
+        if (fd != STDIN_FILENO)
+            close(fd);
+        throw;
+    }
+
+    bytesPerFrame = format.channels * sampleBytes(format.sampleFormat);
+}
+
+StreamAudioSource::~StreamAudioSource() {
+    if (fd != STDIN_FILENO)
+        close(fd);
+}
+
+bool StreamAudioSource::fill(size_t count) {
+    while (bufferEnd - bufferStart < count) {
+        if (endOfStream)
+            return false;
+
+        /* Move the partial remainder to the front, to read a large block after it */
+        if (bufferStart > 0) {
+            std::memmove(buffer.data(), buffer.data() + bufferStart, bufferEnd - bufferStart);
+            bufferEnd -= bufferStart;
+            bufferStart = 0;
+        }
+        if (count > buffer.size())
+            buffer.resize(count);
+
+        ssize_t ret = ::read(fd, buffer.data() + bufferEnd, buffer.size() - bufferEnd);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            throw ReadException("Error reading audio stream: " + std::string(std::strerror(errno)));
+        } else if (ret == 0) {
+            endOfStream = true;
+        }
+
+        bufferEnd += static_cast<size_t>(ret);
+    }
+
+    return true;
+}
+
+void StreamAudioSource::consume(size_t count) {
+    bufferStart += count;
+}
+
+void StreamAudioSource::parseHeader() {
+    if (!fill(12) || std::memcmp(buffer.data() + bufferStart, "RIFF", 4) != 0 || std::memcmp(buffer.data() + bufferStart + 8, "WAVE", 4) != 0)
+        throw FormatException("Error opening audio stream: not a RIFF WAVE stream.");
+    consume(12);
+
+    bool haveFormat = false;
+
+    /* Walk the chunks up to the data chunk, skipping over the others */
+    while (fill(8)) {
+        const uint8_t *chunk = buffer.data() + bufferStart;
+        uint32_t chunkSize = readLe32(chunk + 4);
+        bool isFormat = std::memcmp(chunk, "fmt ", 4) == 0;
+        bool isData = std::memcmp(chunk, "data", 4) == 0;
+        consume(8);
+
+        if (isData) {
+            if (!haveFormat)
+                throw FormatException("Error opening audio stream: data chunk before format chunk.");
+
+            /* Streamed writers leave the size unset or at its maximum, read to the end */
+            if (chunkSize != 0 && chunkSize != 0xffffffff)
+                dataRemaining = chunkSize;
+            return;
+        }
+
+        /* Chunks are padded to even sizes */
+        size_t skip = chunkSize + (chunkSize & 1);
+        if (isFormat) {
+            if (chunkSize > 1024 || !fill(skip))
+                break;
+            format = parseWaveFormat(buffer.data() + bufferStart, chunkSize);
+            haveFormat = true;
+            consume(skip);
+        } else {
+            while (skip > 0 && fill(1)) {
+                size_t count = std::min(skip, bufferEnd - bufferStart);
+                consume(count);
+                skip -= count;
+            }
+        }
+    }
+
+    throw FormatException("Error opening audio stream: no data chunk.");
+}
+
+size_t StreamAudioSource::read(double *samples, size_t count) {
+    /* Block for one frame, then take whatever else has arrived */
+    if (dataRemaining < bytesPerFrame || !fill(bytesPerFrame))
+        return 0;
+
+    count = std::min(count, (bufferEnd - bufferStart) / bytesPerFrame);
+    count = std::min<uint64_t>(count, dataRemaining / bytesPerFrame);
+
+    convertSamples(format.sampleFormat, buffer.data() + bufferStart, count * format.channels, samples);
+    consume(count * bytesPerFrame);
+    dataRemaining -= count * bytesPerFrame;
+
+    return count;
+}
+
+unsigned int StreamAudioSource::getSampleRate() {
+    return format.sampleRate;
+}
+
+unsigned int StreamAudioSource::getChannels() {
+    return format.channels;
+}
+}
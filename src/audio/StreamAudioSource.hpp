@@ -0,0 +1,52 @@
+#ifndef _STREAMAUDIOSOURCE_HPP
+#define _STREAMAUDIOSOURCE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "AudioSource.hpp"
+#include "SampleFormat.hpp"
+
+namespace Audio {
+
+/* Non-seekable audio stream source, for stdin ("-") and FIFOs: a WAV stream,
+ * or headerless little-endian PCM of a given format, sample rate and channel
+ * count. Reads are buffered in large blocks, and read() returns as soon as
+ * some frames have arrived, so the spectrogram keeps up with the stream. */
+class StreamAudioSource : public AudioSource {
+  public:
+    enum class Format { Wav,
+                        S16,
+                        S32,
+                        F32 };
+
+    StreamAudioSource(std::string path, Format format, unsigned int sampleRate = 0, unsigned int channels = 1);
+    ~StreamAudioSource();
+    virtual size_t read(double *samples, size_t count);
+    virtual unsigned int getSampleRate();
+    virtual unsigned int getChannels();
+
+  private:
+    /* Fill the buffer with at least count bytes, false at end of stream */
+    bool fill(size_t count);
+    /* Consume count bytes from the buffer */
+    void consume(size_t count);
+    void parseHeader();
+
+    int fd;
+    WaveFormat format;
+    size_t bytesPerFrame;
+
+    /* Buffered stream bytes, valid from bufferStart to bufferEnd */
+    std::vector<uint8_t> buffer;
+    size_t bufferStart;
+    size_t bufferEnd;
+    bool endOfStream;
+
+    /* Bytes of the WAV data chunk left, unbounded for raw streams */
+    uint64_t dataRemaining;
+};
+}
+
+#endif
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "UdpAudioSource.hpp"
+
+namespace Audio {
+
+/* Packets received per recvmmsg() call, and the largest packet */
+static const size_t BatchSize = 32;
+static const size_t PacketSize = 65536;
+/* Jitter buffer slots, the most packets held back, and the most frames kept of a packet */
+static const size_t Slots = 128;
+static const size_t SlotFrames = UdpPacketHeader::MaxFrames;
+/* Receive buffer requested from the kernel */
+static const int ReceiveBufferSize = 4 * 1024 * 1024;
+
+UdpAudioSource::UdpAudioSource(std::string address, unsigned int sampleRate, unsigned int channels, unsigned int jitter) : fd(-1), sampleRate(sampleRate), channels(channels), jitter(std::chrono::milliseconds(jitter)), packets(BatchSize * PacketSize), messages(BatchSize), iovecs(BatchSize), slots(Slots), receiving(false), started(false), nextSequence(0), highestSequence(0), highestPosition(0), playPosition(0), current(nullptr), currentOffset(0), gapFrames(0), missing(false), dry(false), silenceSince(std::chrono::steady_clock::now()), overflows(0), underflows(0), samplesLost(0), latencyMicroseconds(0) {
+    if (sampleRate == 0 || channels == 0)
+        throw OpenException("Opening UDP source: invalid sample rate or channel count.");
+
+    /* Split [host:]port, the host may be a bracketed IPv6 address */
+    std::string host, port = address;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+            host = host.substr(1, host.size() - 2);
+    }
+
+    struct addrinfo hints, *result;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    int ret = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+    if (ret != 0)
+        throw OpenException("Opening UDP source: getaddrinfo(): " + std::string(gai_strerror(ret)));
+
+    for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol)) < 0)
+            continue;
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0)
+        throw OpenException("Opening UDP source: bind(): " + std::string(std::strerror(errno)));
+
+    /* Best effort, room for bursts between reads */
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &ReceiveBufferSize, sizeof(ReceiveBufferSize));
+
+    for (size_t i = 0; i < BatchSize; i++) {
+        iovecs[i].iov_base = packets.data() + i * PacketSize;
+        iovecs[i].iov_len = PacketSize;
+        std::memset(&messages[i], 0, sizeof(messages[i]));
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for (auto &slot : slots) {
+        slot.valid = false;
+        slot.samples.resize(SlotFrames * channels);
+    }
+}
+
+UdpAudioSource::~UdpAudioSource() {
+    ::close(fd);
+}
+
+void UdpAudioSource::receive(std::chrono::steady_clock::duration timeout) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+    if (poll(&pfd, 1, std::max(ms, 1)) <= 0)
+        return;
+
+    /* Drain the socket a batch at a time */
+    int count;
+    do {
+        if ((count = recvmmsg(fd, messages.data(), BatchSize, MSG_DONTWAIT, nullptr)) <= 0)
+            break;
+
+        std::chrono::steady_clock::time_point arrival = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            store(packets.data() + static_cast<size_t>(i) * PacketSize, messages[static_cast<size_t>(i)].msg_len, arrival);
+    } while (static_cast<size_t>(count) == BatchSize);
+}
+
+void UdpAudioSource::store(const uint8_t *packet, size_t size, std::chrono::steady_clock::time_point arrival) {
+    UdpPacketHeader header;
+    if (!header.decode(packet, size) || header.sampleRate != sampleRate || header.channels != channels)
+        return;
+
+    size_t frames = (size - UdpPacketHeader::Size) / (sampleBytes(header.format) * channels);
+    if (frames == 0 || frames > SlotFrames)
+        return;
+
+    /* The first packet, or an earlier one while pre-buffering, starts the stream */
+    if (!receiving || (!started && static_cast<int32_t>(header.sequence - nextSequence) < 0)) {
+        if (!receiving) {
+            receiving = true;
+            firstArrival = arrival;
+            highestSequence = header.sequence;
+            highestPosition = 0;
+        }
+        nextSequence = header.sequence;
+        playPosition = header.timestamp;
+    }
+
+    int32_t ahead = static_cast<int32_t>(header.sequence - nextSequence);
+    bool drained = static_cast<int32_t>(highestSequence - nextSequence) < 0 && current == nullptr;
+
+    /* Sender restarted: far out of the window, or behind once the jitter
+     * buffer ran dry. Follow it with a new pre-buffer. */
+    if (drained && (ahead < -static_cast<int32_t>(Slots) || ahead >= static_cast<int32_t>(Slots) || (dry && ahead < 0))) {
+        receiving = false;
+        started = false;
+        store(packet, size, arrival);
+        return;
+    }
+    /* Too late, its frames were already filled in */
+    if (ahead < 0)
+        return;
+    /* Too early, the jitter buffer is full */
+    if (ahead >= static_cast<int32_t>(Slots)) {
+        overflows++;
+        return;
+    }
+
+    Slot &slot = slots[header.sequence % Slots];
+    convertSamples(header.format, packet + UdpPacketHeader::Size, frames * channels, slot.samples.data());
+    slot.valid = true;
+    slot.sequence = header.sequence;
+    slot.timestamp = header.timestamp;
+    slot.frames = frames;
+    slot.arrival = arrival;
+
+    if (static_cast<int32_t>(header.sequence - highestSequence) > 0)
+        highestSequence = header.sequence;
+    highestPosition = std::max(highestPosition, header.timestamp + frames);
+    lastArrival = arrival;
+}
+
+size_t UdpAudioSource::read(double *samples, size_t count) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    size_t done = 0;
+
+    while (done < count) {
+        /* Fill the gap of lost packets with zeros */
+        if (gapFrames > 0) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(gapFrames, count - done));
+            std::fill(samples + done * channels, samples + (done + n) * channels, 0.0);
+            if (done == 0)
+                readTimestamp = now;
+            gapFrames -= n;
+            playPosition += n;
+            samplesLost += n;
+            done += n;
+            continue;
+        }
+
+        /* Read on from the current packet */
+        if (current != nullptr) {
+            size_t n = std::min(current->frames - currentOffset, count - done);
+            std::copy(current->samples.data() + currentOffset * channels, current->samples.data() + (currentOffset + n) * channels, samples + done * channels);
+            if (done == 0)
+                readTimestamp = current->arrival - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(current->frames - currentOffset) / sampleRate));
+            currentOffset += n;
+            playPosition += n;
+            done += n;
+
+            if (currentOffset == current->frames) {
+                current->valid = false;
+                current = nullptr;
+            }
+            continue;
+        }
+
+        if (started) {
+            Slot &slot = slots[nextSequence % Slots];
+
+            /* Next packet is in */
+            if (slot.valid && slot.sequence == nextSequence) {
+                nextSequence++;
+                missing = false;
+                dry = false;
+
+                current = &slot;
+                currentOffset = 0;
+
+                if (slot.timestamp > playPosition + sampleRate || slot.timestamp + sampleRate < playPosition) {
+                    /* Sender restarted or jumped, follow it */
+                    playPosition = slot.timestamp;
+                } else if (slot.timestamp > playPosition) {
+                    /* Packets before it were lost */
+                    gapFrames = slot.timestamp - playPosition;
+                } else {
+                    /* Overlaps frames already read */
+                    currentOffset = static_cast<size_t>(std::min<uint64_t>(playPosition - slot.timestamp, slot.frames));
+                }
+                continue;
+            }
+
+            /* Next packet is missing, give up on it once the buffer is full past it or at its deadline */
+            int32_t ahead = static_cast<int32_t>(highestSequence - nextSequence);
+            if (ahead > 0) {
+                if (!missing) {
+                    missing = true;
+                    missingSince = now;
+                }
+                if (ahead >= static_cast<int32_t>(Slots / 2) || now - missingSince >= jitter) {
+                    nextSequence++;
+                    missing = false;
+                    continue;
+                }
+            } else if (!dry && now - lastArrival >= jitter) {
+                /* Ran dry, keep the stream going with silence until packets return */
+                underflows++;
+                dry = true;
+                silenceSince = now;
+            }
+        } else if (receiving && now - firstArrival >= jitter) {
+            /* Pre-buffered */
+            started = true;
+            continue;
+        }
+
+        /* Return what we have rather than wait */
+        if (done > 0)
+            break;
+
+        /* Sender quiet or not heard from yet, fill in silence for the time passed */
+        if ((dry || !receiving) && now - silenceSince >= std::chrono::milliseconds(1)) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(static_cast<uint64_t>(std::chrono::duration<double>(now - silenceSince).count() * sampleRate), count));
+            std::chrono::steady_clock::duration duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(n) / sampleRate));
+            std::fill(samples, samples + n * channels, 0.0);
+            readTimestamp = silenceSince;
+            silenceSince += duration;
+            playPosition += n;
+            done = n;
+            if (n > 0)
+                break;
+        }
+
+        /* Wait for packets, up to the next deadline */
+        std::chrono::steady_clock::duration timeout = jitter;
+        if (dry || !receiving)
+            timeout = std::chrono::milliseconds(10);
+        else if (missing)
+            timeout = missingSince + jitter - now;
+        else if (!started)
+            timeout = firstArrival + jitter - now;
+        else
+            timeout = lastArrival + jitter - now;
+        receive(timeout);
+        now = std::chrono::steady_clock::now();
+    }
+
+    latencyMicroseconds = (highestPosition > playPosition) ? static_cast<unsigned int>((highestPosition - playPosition) * 1000000 / sampleRate) : 0;
+
+    return done;
+}
+
+unsigned int UdpAudioSource::getSampleRate() {
+    return sampleRate;
+}
+
+unsigned int UdpAudioSource::getChannels() {
+    return channels;
+}
+
+std::chrono::steady_clock::time_point UdpAudioSource::getReadTimestamp() {
+    return readTimestamp;
+}
+
+size_t UdpAudioSource::getDebugOverflows() {
+    return overflows;
+}
+
+size_t UdpAudioSource::getDebugUnderflows() {
+    return underflows;
+}
+
+size_t UdpAudioSource::getDebugSamplesLost() {
+    return samplesLost;
+}
+
+unsigned int UdpAudioSource::getDebugLatency() {
+    return latencyMicroseconds / 1000;
+}
+}
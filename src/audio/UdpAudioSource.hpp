@@ -0,0 +1,99 @@
+#ifndef _UDPAUDIOSOURCE_HPP
+#define _UDPAUDIOSOURCE_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <sys/socket.h>
+
+#include "AudioSource.hpp"
+#include "UdpPacket.hpp"
+
+namespace Audio {
+
+/* PCM over UDP source (see UdpPacket.hpp). Packets are received in batches
+ * with recvmmsg(), and reordered in a jitter buffer by sequence number. A
+ * packet that hasn't arrived by the time the jitter buffer is full, or its
+ * jitter deadline has passed, is given up on, and its gap in the stream is
+ * filled with zeros. When the jitter buffer runs dry, the stream is kept
+ * going with silence in real time, and picks up where the packets' timestamps
+ * say when they return. A restarted sender is followed with a new pre-buffer. */
+class UdpAudioSource : public AudioSource {
+  public:
+    /* Listen on [address:]port, for packets of this sample rate and channel
+     * count, held back for up to jitter milliseconds */
+    UdpAudioSource(std::string address, unsigned int sampleRate, unsigned int channels, unsigned int jitter);
+    ~UdpAudioSource();
+    virtual size_t read(double *samples, size_t count);
+    virtual unsigned int getSampleRate();
+    virtual unsigned int getChannels();
+    virtual std::chrono::steady_clock::time_point getReadTimestamp();
+
+    /* Debug Statistics */
+    virtual size_t getDebugOverflows();
+    virtual size_t getDebugUnderflows();
+    virtual size_t getDebugSamplesLost();
+    virtual unsigned int getDebugLatency();
+
+  private:
+    /* Jitter buffer slot, one per sequence number modulo the slot count */
+    struct Slot {
+        bool valid;
+        uint32_t sequence;
+        uint64_t timestamp;
+        size_t frames;
+        std::chrono::steady_clock::time_point arrival;
+        std::vector<double> samples;
+    };
+
+    /* Receive packets into the jitter buffer, waiting up to timeout for the first */
+    void receive(std::chrono::steady_clock::duration timeout);
+    void store(const uint8_t *packet, size_t size, std::chrono::steady_clock::time_point arrival);
+
+    int fd;
+    const unsigned int sampleRate;
+    const unsigned int channels;
+    const std::chrono::steady_clock::duration jitter;
+
+    /* Batched receive buffers */
+    std::vector<uint8_t> packets;
+    std::vector<struct mmsghdr> messages;
+    std::vector<struct iovec> iovecs;
+
+    /* Jitter buffer, pre-buffered for the jitter time from the first arrival */
+    std::vector<Slot> slots;
+    bool receiving;
+    bool started;
+    std::chrono::steady_clock::time_point firstArrival;
+    std::chrono::steady_clock::time_point lastArrival;
+    uint32_t nextSequence;
+    uint32_t highestSequence;
+    /* Stream position past the newest frame received */
+    uint64_t highestPosition;
+    /* Stream position of the next frame read */
+    uint64_t playPosition;
+    /* Slot being read, and frames read from it */
+    Slot *current;
+    size_t currentOffset;
+    /* Zeros left to fill a gap of lost packets */
+    uint64_t gapFrames;
+    /* Time the next packet was first found missing */
+    std::chrono::steady_clock::time_point missingSince;
+    bool missing;
+    /* Ran dry, and time up to which silence was filled in for a quiet sender */
+    bool dry;
+    std::chrono::steady_clock::time_point silenceSince;
+
+    std::chrono::steady_clock::time_point readTimestamp;
+
+    std::atomic<size_t> overflows;
+    std::atomic<size_t> underflows;
+    std::atomic<size_t> samplesLost;
+    std::atomic<unsigned int> latencyMicroseconds;
+};
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _UDPPACKET_HPP
+#define _UDPPACKET_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SampleFormat.hpp"
+
+namespace Audio {
+
+/* UDP PCM packet: a header in network byte order, followed by interleaved
+ * little-endian samples.
+ *
+ *  0  magic        "APCM"
+ *  4  sequence     packet sequence number, wraps around
+ *  8  timestamp    sample frame position of the first frame in the stream
+ * 16  sampleRate   Hz
+ * 20  channels
+ * 22  format       SampleFormat
+ *
+ * A packet carries up to MaxFrames frames.
+ */
+struct UdpPacketHeader {
+    static const size_t Size = 24;
+    static const uint32_t Magic = 0x4150434d;
+    static const size_t MaxFrames = 2048;
+
+    uint32_t sequence;
+    uint64_t timestamp;
+    uint32_t sampleRate;
+    uint16_t channels;
+    SampleFormat format;
+
+    /* Write header to a packet of at least Size bytes */
+    void encode(uint8_t *packet) const;
+    /* Read header from a packet, false if it isn't one */
+    bool decode(const uint8_t *packet, size_t size);
+};
+
+inline void UdpPacketHeader::encode(uint8_t *packet) const {
+    uint64_t fields[] = {Magic, sequence, timestamp >> 32, timestamp & 0xffffffff, sampleRate, (static_cast<uint64_t>(channels) << 16) | static_cast<uint16_t>(format)};
+    for (size_t i = 0; i < 6; i++) {
+        for (size_t b = 0; b < 4; b++)
+            packet[4 * i + b] = static_cast<uint8_t>(fields[i] >> (24 - 8 * b));
+    }
+}
+
+inline bool UdpPacketHeader::decode(const uint8_t *packet, size_t size) {
+    if (size < Size)
+        return false;
+
+    uint32_t fields[6];
+    for (size_t i = 0; i < 6; i++)
+        fields[i] = (static_cast<uint32_t>(packet[4 * i]) << 24) | (static_cast<uint32_t>(packet[4 * i + 1]) << 16) | (static_cast<uint32_t>(packet[4 * i + 2]) << 8) | static_cast<uint32_t>(packet[4 * i + 3]);
+
+    if (fields[0] != Magic || (fields[5] & 0xffff) > static_cast<uint32_t>(SampleFormat::F32))
+        return false;
+
+    sequence = fields[1];
+    timestamp = (static_cast<uint64_t>(fields[2]) << 32) | fields[3];
+    sampleRate = fields[4];
+    channels = static_cast<uint16_t>(fields[5] >> 16);
+    format = static_cast<SampleFormat>(fields[5] & 0xffff);
+    return true;
+}
+}
+
+#endif
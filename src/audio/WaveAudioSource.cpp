@@ -1,5 +1,6 @@
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 
 #include <sndfile.h>
 
@@ -10,9 +11,6 @@ namespace Audio {
 WaveAudioSource::WaveAudioSource(std::string path) : sfinfo() {
     if ((sndfile = sf_open(path.c_str(), SFM_READ, &sfinfo)) == nullptr)
         throw OpenException("Error opening WAV file: " + std::string(sf_strerror(nullptr)));
-
-    if (sfinfo.channels != 1)
-        throw OpenException("Error: only one channel supported.");
 }
 
 WaveAudioSource::~WaveAudioSource() {
@@ -20,17 +18,32 @@ WaveAudioSource::~WaveAudioSource() {
         sf_close(sndfile);
 }
 
-void WaveAudioSource::read(std::vector<double> &samples) {
+size_t WaveAudioSource::read(double *samples, size_t count) {
     sf_count_t ret;
 
-    ret = sf_read_double(sndfile, samples.data(), static_cast<sf_count_t>(samples.size()));
+    ret = sf_readf_double(sndfile, samples, static_cast<sf_count_t>(count));
+
+    /* Short read at end of file */
+    return static_cast<size_t>(std::max<sf_count_t>(ret, 0));
+}
+
+uint64_t WaveAudioSource::getFrames() {
+    return sfinfo.seekable ? static_cast<uint64_t>(sfinfo.frames) : 0;
+}
+
+bool WaveAudioSource::seek(uint64_t frame) {
+    if (!sfinfo.seekable)
+        return false;
 
-    /* Resize samples buffer if we read less than requested */
-    if (ret < static_cast<sf_count_t>(samples.size()))
-        samples.resize(static_cast<size_t>(ret));
+    sf_count_t target = std::min(static_cast<sf_count_t>(frame), sfinfo.frames);
+    return sf_seek(sndfile, target, SEEK_SET) == target;
 }
 
 unsigned int WaveAudioSource::getSampleRate() {
     return static_cast<unsigned int>(sfinfo.samplerate);
 }
+
+unsigned int WaveAudioSource::getChannels() {
+    return static_cast<unsigned int>(sfinfo.channels);
+}
 }
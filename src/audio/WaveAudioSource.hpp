@@ -13,8 +13,11 @@ class WaveAudioSource : public AudioSource {
   public:
     WaveAudioSource(std::string path);
     ~WaveAudioSource();
-    virtual void read(std::vector<double> &samples);
+    virtual size_t read(double *samples, size_t count);
+    virtual uint64_t getFrames();
+    virtual bool seek(uint64_t frame);
     virtual unsigned int getSampleRate();
+    virtual unsigned int getChannels();
 
   private:
     SNDFILE *sndfile;
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "BandDecimator.hpp"
+
+namespace DFT {
+
+/* Taps per unit of decimation, for a transition band of about a sixth of the band */
+static const size_t TapsPerDecimation = 64;
+
+/* Dot products of x with the real and imaginary taps */
+static void complexDot(const double *x, const double *re, const double *im, size_t n, double &outRe, double &outIm) {
+    size_t k = 0;
+    double sumRe = 0, sumIm = 0;
+
+#ifdef __SSE2__
+    __m128d accRe0 = _mm_setzero_pd(), accRe1 = _mm_setzero_pd();
+    __m128d accIm0 = _mm_setzero_pd(), accIm1 = _mm_setzero_pd();
+    for (; k + 4 <= n; k += 4) {
+        __m128d x0 = _mm_loadu_pd(x + k), x1 = _mm_loadu_pd(x + k + 2);
+        accRe0 = _mm_add_pd(accRe0, _mm_mul_pd(x0, _mm_loadu_pd(re + k)));
+        accRe1 = _mm_add_pd(accRe1, _mm_mul_pd(x1, _mm_loadu_pd(re + k + 2)));
+        accIm0 = _mm_add_pd(accIm0, _mm_mul_pd(x0, _mm_loadu_pd(im + k)));
+        accIm1 = _mm_add_pd(accIm1, _mm_mul_pd(x1, _mm_loadu_pd(im + k + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(accRe0, accRe1));
+    sumRe = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, _mm_add_pd(accIm0, accIm1));
+    sumIm = lanes[0] + lanes[1];
+#endif
+
+    for (; k < n; k++) {
+        sumRe += x[k] * re[k];
+        sumIm += x[k] * im[k];
+    }
+
+    outRe = sumRe;
+    outIm = sumIm;
+}
+
+BandDecimator::BandDecimator(unsigned int sampleRate, double bandStart, unsigned int decimation) : decimation(decimation), skip(0), phase(0), phaseStep(0), quarter(0) {
+    double bandwidth = static_cast<double>(sampleRate) / (2.0 * decimation);
+    if (decimation == 0 || bandStart < 0 || bandStart + bandwidth > static_cast<double>(sampleRate) / 2.0)
+        throw BandException("Error: band " + std::to_string(static_cast<unsigned int>(bandStart)) + " - " + std::to_string(static_cast<unsigned int>(bandStart + bandwidth)) + " Hz is outside of the sample rate's 0 - " + std::to_string(sampleRate / 2) + " Hz.");
+
+    /* Blackman windowed sinc low pass, cut off at half the band */
+    size_t N = getTaps(decimation);
+    double cutoff = 1.0 / (4.0 * decimation);
+    std::vector<double> lowpass(N);
+    double gain = 0;
+    for (size_t k = 0; k < N; k++) {
+        double t = static_cast<double>(k) - static_cast<double>(N - 1) / 2.0;
+        double sinc = (t == 0) ? 1.0 : std::sin(2.0 * M_PI * cutoff * t) / (2.0 * M_PI * cutoff * t);
+        double window = 0.42 - 0.5 * std::cos(2.0 * M_PI * static_cast<double>(k) / static_cast<double>(N - 1)) + 0.08 * std::cos(4.0 * M_PI * static_cast<double>(k) / static_cast<double>(N - 1));
+        lowpass[k] = sinc * window;
+        gain += lowpass[k];
+    }
+
+    /* Shift it to the band's center, time reversed for the dot product with
+     * the newest sample last: tap k multiplies x[n - (N - 1 - k)] */
+    double center = 2.0 * M_PI * (bandStart + bandwidth / 2.0) / static_cast<double>(sampleRate);
+    tapsRe.resize(N);
+    tapsIm.resize(N);
+    for (size_t k = 0; k < N; k++) {
+        double h = lowpass[N - 1 - k] / gain;
+        double w = center * static_cast<double>(N - 1 - k);
+        tapsRe[k] = h * std::cos(w);
+        tapsIm[k] = h * std::sin(w);
+    }
+
+    phaseStep = std::fmod(center * decimation, 2.0 * M_PI);
+    history.assign(N - 1, 0.0);
+}
+
+size_t BandDecimator::process(const double *input, size_t count, double *output) {
+    const size_t N = tapsRe.size();
+
+    /* Only allocates if the count grows */
+    history.resize(N - 1 + count);
+    std::copy(input, input + count, history.begin() + static_cast<std::ptrdiff_t>(N - 1));
+
+    size_t written = 0;
+    size_t n = skip;
+    for (; n < count; n += decimation) {
+        /* Band pass output at the newest sample n, mixed down to 0 Hz */
+        double re, im;
+        complexDot(history.data() + n, tapsRe.data(), tapsIm.data(), N, re, im);
+        double c = std::cos(phase), s = std::sin(phase);
+        double zRe = re * c + im * s, zIm = im * c - re * s;
+
+        /* Shift up by a quarter of the output rate and take the real part,
+         * doubled for the half of the spectrum it drops */
+        switch (quarter) {
+        case 0:
+            output[written++] = 2.0 * zRe;
+            break;
+        case 1:
+            output[written++] = -2.0 * zIm;
+            break;
+        case 2:
+            output[written++] = -2.0 * zRe;
+            break;
+        case 3:
+            output[written++] = 2.0 * zIm;
+            break;
+        }
+        quarter = (quarter + 1) & 3;
+
+        phase += phaseStep;
+        if (phase >= 2.0 * M_PI)
+            phase -= 2.0 * M_PI;
+    }
+    skip = n - count;
+
+    /* Keep the last N - 1 samples for the next call */
+    std::copy(history.end() - static_cast<std::ptrdiff_t>(N - 1), history.end(), history.begin());
+    history.resize(N - 1);
+
+    return written;
+}
+
+unsigned int BandDecimator::getDecimation() {
+    return decimation;
+}
+
+size_t BandDecimator::getTaps() {
+    return tapsRe.size();
+}
+
+size_t BandDecimator::getTaps(unsigned int decimation) {
+    return TapsPerDecimation * decimation + 1;
+}
+}
@@ -0,0 +1,59 @@
+#ifndef _BANDDECIMATOR_HPP
+#define _BANDDECIMATOR_HPP
+
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+namespace DFT {
+
+/* Selects the band [bandStart, bandStart + sampleRate / (2 * decimation)]
+ * of a real signal, and decimates it to sampleRate / decimation, so it can
+ * be analyzed at high resolution with a small DFT.
+ *
+ * The band is mixed to be centered at 0 Hz and low pass filtered by a
+ * complex band pass polyphase FIR (the mixing is folded into the taps, so
+ * the filter only runs at the output rate), and shifted back up by a
+ * quarter of the output rate. Its real part is then the band at
+ * [0, sampleRate / (2 * decimation)]. */
+class BandDecimator {
+  public:
+    BandDecimator(unsigned int sampleRate, double bandStart, unsigned int decimation);
+
+    /* Decimate count samples, returns number of samples written to output,
+     * at most count / decimation + 1 */
+    size_t process(const double *input, size_t count, double *output);
+
+    unsigned int getDecimation();
+    size_t getTaps();
+    /* Taps of the filter for a decimation, the output lagging the input by
+     * (taps - 1) / 2 input samples, a whole number of output samples */
+    static size_t getTaps(unsigned int decimation);
+
+  private:
+    const unsigned int decimation;
+
+    /* Complex band pass taps, time reversed, as real and imaginary parts */
+    std::vector<double> tapsRe;
+    std::vector<double> tapsIm;
+
+    /* Last taps - 1 input samples, followed by the samples being processed */
+    std::vector<double> history;
+    /* Input samples to skip before the next output */
+    size_t skip;
+
+    /* Mixer phase at the next output, and its step per output */
+    double phase;
+    double phaseStep;
+    /* Output index modulo 4, for the quarter rate shift */
+    unsigned int quarter;
+};
+
+class BandException : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+
+#endif
@@ -1,6 +1,8 @@
 #include <stdexcept>
 #include <cmath>
 #include <complex>
+#include <mutex>
+#include <map>
 
 #include "RealDft.hpp"
 
@@ -41,13 +43,58 @@ static void calculateWindow(std::vector<double> &window, RealDft::WindowFunction
     }
 }
 
+/* FFTW planning and allocation are not thread-safe, only execution is. */
+static std::mutex plannerLock;
+/* Live instances, FFTW is cleaned up after the last one */
+static unsigned int instances = 0;
+
+/* Plan cache: one plan per size, shared by every instance of that size, so
+ * analysis chains side by side plan each size once and compute with the same
+ * algorithm. Instances execute the plan on buffers of their own, which FFTW
+ * allows concurrently for buffers aligned like the planned ones, as
+ * fftw_alloc_*() buffers are. Guarded by plannerLock. */
+struct CachedPlan {
+    fftw_plan plan;
+    unsigned int references;
+};
+static std::map<unsigned int, CachedPlan> plans;
+
+static fftw_plan acquirePlan(unsigned int N, double *samples, fftw_complex *dft) {
+    auto it = plans.find(N);
+    if (it != plans.end()) {
+        it->second.references++;
+        return it->second.plan;
+    }
+
+    fftw_plan plan = fftw_plan_dft_r2c_1d(static_cast<int>(N), samples, dft, FFTW_MEASURE);
+    if (plan == nullptr)
+        throw AllocationException("Planning DFT.");
+
+    plans[N] = {plan, 1};
+    return plan;
+}
+
+static void releasePlan(unsigned int N) {
+    auto it = plans.find(N);
+    if (it != plans.end() && --it->second.references == 0) {
+        fftw_destroy_plan(it->second.plan);
+        plans.erase(it);
+    }
+}
+
 RealDft::RealDft(unsigned int N, RealDft::WindowFunction wf) : N(N), windowFunction(wf), wsamples(nullptr), dft(nullptr), plan(nullptr) {
+    {
+        std::lock_guard<std::mutex> lg(plannerLock);
+        instances++;
+    }
     setSize(N);
 }
 
 RealDft::~RealDft() {
+    std::lock_guard<std::mutex> lg(plannerLock);
+
     if (plan) {
-        fftw_destroy_plan(plan);
+        releasePlan(N);
         plan = nullptr;
     }
     if (dft) {
@@ -58,7 +105,8 @@ RealDft::~RealDft() {
         fftw_free(wsamples);
         wsamples = nullptr;
     }
-    fftw_cleanup();
+    if (--instances == 0)
+        fftw_cleanup();
 }
 
 void RealDft::compute(std::vector<std::complex<double>> &dft, const std::vector<double> &samples) {
@@ -66,6 +114,10 @@ void RealDft::compute(std::vector<std::complex<double>> &dft, const std::vector<
     if (samples.size() != N)
         throw SizeMismatchException("Samples size does not match DFT size!");
 
+    compute(dft, samples.data());
+}
+
+void RealDft::compute(std::vector<std::complex<double>> &dft, const double *samples) {
     /* Size dft buffer correctly */
     dft.resize(N / 2 + 1);
 
@@ -73,8 +125,8 @@ void RealDft::compute(std::vector<std::complex<double>> &dft, const std::vector<
     for (unsigned int n = 0; n < N; n++)
         wsamples[n] = samples[n] * window[n];
 
-    /* Execute DFT */
-    fftw_execute(plan);
+    /* Execute DFT on our buffers */
+    fftw_execute_dft_r2c(plan, wsamples, this->dft);
 
     /* Compute DFT magnitude */
     for (unsigned int n = 0; n < N / 2 + 1; n++)
@@ -86,9 +138,11 @@ unsigned int RealDft::getSize() {
 }
 
 void RealDft::setSize(unsigned int N) {
+    std::lock_guard<std::mutex> lg(plannerLock);
+
     /* Deallocate FFTW resources we are changing */
     if (plan) {
-        fftw_destroy_plan(plan);
+        releasePlan(this->N);
         plan = nullptr;
     }
     if (dft) {
@@ -115,8 +169,8 @@ void RealDft::setSize(unsigned int N) {
     if (dft == nullptr)
         throw AllocationException("Allocating DFT memory.");
 
-    /* Rebuild our plan */
-    plan = fftw_plan_dft_r2c_1d(static_cast<int>(N), wsamples, dft, FFTW_MEASURE);
+    /* Take the plan for the new size */
+    plan = acquirePlan(N, wsamples, dft);
 
     /* Update N */
     this->N = N;
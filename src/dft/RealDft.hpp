@@ -20,6 +20,8 @@ class RealDft {
 
     /* Compute new DFT magnitude based on samples */
     void compute(std::vector<std::complex<double>> &dft, const std::vector<double> &samples);
+    /* Compute new DFT magnitude based on N contiguous samples */
+    void compute(std::vector<std::complex<double>> &dft, const double *samples);
 
     /* Get/Set DFT Size */
     unsigned int getSize();
@@ -40,7 +42,7 @@ class RealDft {
     double *wsamples;
     /* Complex DFT */
     fftw_complex *dft;
-    /* FFTW Plan */
+    /* FFTW Plan, shared with instances of the same size */
     fftw_plan plan;
 };
 
@@ -0,0 +1,140 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "SlidingWindow.hpp"
+#include "RealDft.hpp"
+
+namespace DFT {
+
+static size_t roundUpPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+SlidingWindow::SlidingWindow(size_t N) : N(0), capacity(0), ring(nullptr), position(0) {
+    setSize(N);
+}
+
+SlidingWindow::~SlidingWindow() {
+    unmapMirrored();
+}
+
+bool SlidingWindow::mapMirrored(size_t capacity) {
+    size_t bytes = capacity * sizeof(double);
+
+    /* Anonymous file holding the ring's physical pages */
+    int fd = memfd_create("audioprism-window", MFD_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, static_cast<off_t>(bytes)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    /* Reserve twice the address space, then map the file into both halves */
+    void *base = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    char *half = static_cast<char *>(base);
+    if (mmap(half, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(half + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, 2 * bytes);
+        close(fd);
+        return false;
+    }
+
+    /* The mappings keep the pages alive */
+    close(fd);
+
+    ring = static_cast<double *>(base);
+    return true;
+}
+
+void SlidingWindow::unmapMirrored() {
+    if (ring) {
+        munmap(ring, 2 * capacity * sizeof(double));
+        ring = nullptr;
+    }
+}
+
+const double *SlidingWindow::window() {
+    if (ring)
+        return ring + ((position - N) & (capacity - 1));
+
+    return linear.data() + position - N;
+}
+
+double *SlidingWindow::writeRegion(size_t count) {
+    if (count > getMaxWrite())
+        throw SizeMismatchException("Write size exceeds sliding window capacity!");
+
+    if (ring)
+        return ring + (position & (capacity - 1));
+
+    /* Out of room at the end, move the window back to the start */
+    if (position + count > linear.size()) {
+        memmove(linear.data(), linear.data() + position - N, sizeof(double) * N);
+        position = N;
+    }
+
+    return linear.data() + position;
+}
+
+void SlidingWindow::commit(size_t count) {
+    position += count;
+}
+
+void SlidingWindow::write(const double *samples, size_t count) {
+    memcpy(writeRegion(count), samples, sizeof(double) * count);
+    commit(count);
+}
+
+size_t SlidingWindow::getSize() {
+    return N;
+}
+
+void SlidingWindow::setSize(size_t N) {
+    /* Room for the window plus at least as many new samples, in whole pages */
+    size_t pageSamples = static_cast<size_t>(sysconf(_SC_PAGESIZE)) / sizeof(double);
+    size_t required = roundUpPowerOfTwo(std::max(2 * N, pageSamples));
+
+    if (required > capacity || (!ring && linear.empty())) {
+        unmapMirrored();
+        linear.clear();
+        linear.shrink_to_fit();
+
+        capacity = required;
+        if (!mapMirrored(capacity))
+            linear.resize(2 * capacity);
+    }
+
+    /* Reset window to zeros */
+    if (ring) {
+        std::fill(ring, ring + capacity, 0.0);
+        position = 0;
+    } else {
+        std::fill(linear.begin(), linear.end(), 0.0);
+        position = N;
+    }
+
+    this->N = N;
+}
+
+size_t SlidingWindow::getMaxWrite() {
+    return capacity - N;
+}
+
+bool SlidingWindow::isMirrored() {
+    return ring != nullptr;
+}
+}
@@ -0,0 +1,61 @@
+#ifndef _SLIDINGWINDOW_HPP
+#define _SLIDINGWINDOW_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace DFT {
+
+/* Sliding window of the most recent N samples, backed by a mirrored ring:
+ * the same physical pages are mapped twice back to back, so both the window
+ * and the region for new samples are always contiguous and sliding the
+ * window never copies. Falls back to a linear buffer that is compacted
+ * occasionally if the mirrored mapping is not available. */
+class SlidingWindow {
+  public:
+    SlidingWindow(size_t N);
+    ~SlidingWindow();
+
+    SlidingWindow(const SlidingWindow &) = delete;
+    SlidingWindow &operator=(const SlidingWindow &) = delete;
+
+    /* Contiguous view of the last N samples, valid until the next write */
+    const double *window();
+
+    /* Contiguous region for the next count new samples, at most getMaxWrite() */
+    double *writeRegion(size_t count);
+    /* Slide the window over count samples written into writeRegion() */
+    void commit(size_t count);
+    /* Copy in and commit count new samples */
+    void write(const double *samples, size_t count);
+
+    /* Get/Set Window Size (resets window to zeros) */
+    size_t getSize();
+    void setSize(size_t N);
+
+    /* Largest single write */
+    size_t getMaxWrite();
+
+    /* True if backed by a mirrored ring, false if by the linear fallback */
+    bool isMirrored();
+
+  private:
+    bool mapMirrored(size_t capacity);
+    void unmapMirrored();
+
+    /* Window Size */
+    size_t N;
+    /* Ring capacity in samples, power of two */
+    size_t capacity;
+
+    /* Mirrored ring: 2 * capacity samples, the second half aliasing the first */
+    double *ring;
+    /* Free-running write position */
+    size_t position;
+
+    /* Linear fallback: 2 * capacity samples, window ends at position */
+    std::vector<double> linear;
+};
+}
+
+#endif
@@ -0,0 +1,23 @@
+#include "BufferImageSink.hpp"
+
+namespace Image {
+
+BufferImageSink::BufferImageSink() : width(0) {}
+
+void BufferImageSink::append(const std::vector<uint32_t> &pixels) {
+    width = pixels.size();
+    this->pixels.insert(this->pixels.end(), pixels.begin(), pixels.end());
+}
+
+void BufferImageSink::write() {}
+
+void BufferImageSink::appendTo(ImageSink &sink) {
+    for (size_t offset = 0; width > 0 && offset < pixels.size(); offset += width) {
+        row.assign(pixels.begin() + static_cast<std::ptrdiff_t>(offset), pixels.begin() + static_cast<std::ptrdiff_t>(offset + width));
+        sink.append(row);
+    }
+
+    pixels.clear();
+    pixels.shrink_to_fit();
+}
+}
@@ -0,0 +1,33 @@
+#ifndef _BUFFERIMAGESINK_HPP
+#define _BUFFERIMAGESINK_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ImageSink.hpp"
+
+namespace Image {
+
+/* Holds the rows appended in memory, to be passed on to another sink in
+ * order later, for the rows of a part of an image rendered out of turn. */
+class BufferImageSink : public ImageSink {
+  public:
+    BufferImageSink();
+
+    virtual void append(const std::vector<uint32_t> &pixels);
+    virtual void write();
+
+    /* Append the rows held to a sink, and drop them */
+    void appendTo(ImageSink &sink);
+
+  private:
+    /* Rows held, end to end */
+    std::vector<uint32_t> pixels;
+    size_t width;
+    /* A row at a time, for the sink passed on to */
+    std::vector<uint32_t> row;
+};
+}
+
+#endif
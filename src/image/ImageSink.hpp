@@ -8,6 +8,11 @@ namespace Image {
 
 class ImageSink {
   public:
+    /* Rows appended top to bottom (vertical), or left to right with the end
+     * of the rows at the top (horizontal) */
+    enum class Orientation { Horizontal,
+                             Vertical };
+
     virtual ~ImageSink() {}
     virtual void append(const std::vector<uint32_t> &pixels) = 0;
     virtual void write() = 0;
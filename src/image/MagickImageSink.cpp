@@ -4,6 +4,7 @@
 #include <Magick++.h>
 
 #include "MagickImageSink.hpp"
+#include "Transpose.hpp"
 
 namespace Image {
 
@@ -16,13 +17,22 @@ void MagickImageSink::append(const std::vector<uint32_t> &pixels) {
 }
 
 void MagickImageSink::write() {
-    Magick::Image image(width, static_cast<unsigned int>(imagePixels.size() / width), "BGRA", Magick::CharPixel, imagePixels.data());
-    image.quality(100);
-    image.opacity(0);
+    unsigned int rows = static_cast<unsigned int>(imagePixels.size() / width);
+
+    /* Horizontal images are transposed into place, rather than rotated after,
+     * and the rows dropped before the image is made */
+    if (orientation == Orientation::Horizontal) {
+        std::vector<uint32_t> columns(imagePixels.size());
+        transposeRows(imagePixels.data(), rows, width, columns.data());
+        imagePixels.swap(columns);
+    }
 
-    if (orientation == Orientation::Horizontal)
-        image.rotate(-90);
+    Magick::Image image((orientation == Orientation::Vertical) ? width : rows, (orientation == Orientation::Vertical) ? rows : width, "BGRA", Magick::CharPixel, imagePixels.data());
+    imagePixels.clear();
+    imagePixels.shrink_to_fit();
 
+    image.quality(100);
+    image.opacity(0);
     image.write(path);
 }
 }
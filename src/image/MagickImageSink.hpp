@@ -9,9 +9,6 @@ namespace Image {
 
 class MagickImageSink : public ImageSink {
   public:
-    enum class Orientation { Horizontal,
-                             Vertical };
-
     MagickImageSink(std::string path, unsigned int width, Orientation orientation);
 
     virtual void append(const std::vector<uint32_t> &pixels);
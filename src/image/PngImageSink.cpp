@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+
+#include <sys/mman.h>
+#include <zlib.h>
+
+#include "PngImageSink.hpp"
+#include "Transpose.hpp"
+
+namespace Image {
+
+/* Filtered bytes deflated per block, and the deflate window primed with */
+static const size_t BlockBytes = 131072;
+static const size_t WindowBytes = 32768;
+
+/* RGB, three bytes per pixel */
+static const size_t PixelBytes = 3;
+
+/* Rows of a horizontal image transposed at a time, long enough for the
+ * columns of a tile to be read back in a few pages each */
+static const size_t TileRows = 256;
+
+static void putUint32(std::vector<uint8_t> &data, size_t offset, unsigned long value) {
+    data[offset] = static_cast<uint8_t>(value >> 24);
+    data[offset + 1] = static_cast<uint8_t>(value >> 16);
+    data[offset + 2] = static_cast<uint8_t>(value >> 8);
+    data[offset + 3] = static_cast<uint8_t>(value);
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+/* Prediction of filter type (None, Sub, Up, Average, Paeth) from the bytes
+ * to the left (a), above (b) and above left (c) */
+static uint8_t predict(unsigned int type, uint8_t a, uint8_t b, uint8_t c) {
+    switch (type) {
+    case 1:
+        return a;
+    case 2:
+        return b;
+    case 3:
+        return static_cast<uint8_t>((a + b) / 2);
+    case 4:
+        return paeth(a, b, c);
+    default:
+        return 0;
+    }
+}
+
+/* Sums of a segment of a row filtered by each filter type, as signed
+ * differences, and the segment filtered by one type. left and aboveLeft are
+ * the pixel before the segment, in the row and in the row above. */
+static void sumSegment(const uint8_t *row, const uint8_t *previous, size_t length, const uint8_t *left, const uint8_t *aboveLeft, unsigned long *sums) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t a = (i >= PixelBytes) ? row[i - PixelBytes] : left[i];
+        uint8_t c = (i >= PixelBytes) ? previous[i - PixelBytes] : aboveLeft[i];
+        for (unsigned int type = 0; type < 5; type++) {
+            uint8_t difference = static_cast<uint8_t>(row[i] - predict(type, a, previous[i], c));
+            sums[type] += (difference < 128) ? difference : 256u - difference;
+        }
+    }
+}
+
+static void filterSegment(const uint8_t *row, const uint8_t *previous, size_t length, const uint8_t *left, const uint8_t *aboveLeft, unsigned int type, uint8_t *output) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t a = (i >= PixelBytes) ? row[i - PixelBytes] : left[i];
+        uint8_t c = (i >= PixelBytes) ? previous[i - PixelBytes] : aboveLeft[i];
+        output[i] = static_cast<uint8_t>(row[i] - predict(type, a, previous[i], c));
+    }
+}
+
+PngImageSink::PngImageSink(std::string path, unsigned int width, Orientation orientation, unsigned int threadCount) : path(path), width(width), orientation(orientation), rows(0), file(nullptr), imageWidth(0), imageHeight(0), current(nullptr), tileRows(0), scratch(nullptr), stopping(false), started(false), adler(adler32(0L, Z_NULL, 0)) {
+    if ((file = std::fopen(path.c_str(), "wb")) == nullptr)
+        throw PngImageException("Error opening PNG image file: " + std::string(std::strerror(errno)));
+
+    try {
+        /* Signature, and a header with the size patched in once written */
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        if (std::fwrite(signature, 1, sizeof(signature), file) != sizeof(signature))
+            throw PngImageException("Error writing PNG image file: " + std::string(std::strerror(errno)));
+        writeHeader();
+
+        if (orientation == Orientation::Horizontal) {
+            /* Unlinked once open, so it goes away with the sink */
+            std::string scratchPath = path + ".columns";
+            if ((scratch = std::fopen(scratchPath.c_str(), "w+b")) == nullptr)
+                throw PngImageException("Error opening PNG image scratch file: " + std::string(std::strerror(errno)));
+            std::remove(scratchPath.c_str());
+        }
+    } catch (...) {
+        if (scratch != nullptr)
+            std::fclose(scratch);
+        std::fclose(file);
+        throw;
+    }
+
+    /* Image rows are filtered a row (vertical), or a tile's column (horizontal), at a time */
+    if (orientation == Orientation::Vertical) {
+        imageWidth = width;
+        row.resize(width * PixelBytes);
+        previousRow.assign(width * PixelBytes, 0);
+        filtered.resize(width * PixelBytes);
+    } else {
+        imageHeight = width;
+        tile.resize(TileRows * width);
+        columns.resize(TileRows * width);
+        tilePixels.resize(TileRows * width * PixelBytes);
+        filtered.resize(TileRows * PixelBytes);
+        zeros.assign(TileRows * PixelBytes, 0);
+    }
+
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned int i = 0; i < threadCount; i++)
+        threads.emplace_back(&PngImageSink::run, this);
+
+    /* A block filling, and up to two per thread compressing or waiting to be written */
+    for (unsigned int i = 0; i < 2 * threadCount + 1; i++) {
+        blocks.emplace_back(new Block);
+        blocks.back()->bytes.resize(WindowBytes + BlockBytes);
+        freeBlocks.push_back(blocks.back().get());
+    }
+
+    current = freeBlocks.back();
+    freeBlocks.pop_back();
+    current->dictionary = current->length = 0;
+}
+
+PngImageSink::~PngImageSink() {
+    {
+        std::lock_guard<std::mutex> lg(lock);
+        stopping = true;
+    }
+    queued.notify_all();
+
+    for (auto &thread : threads)
+        thread.join();
+
+    if (scratch != nullptr)
+        std::fclose(scratch);
+    std::fclose(file);
+}
+
+void PngImageSink::append(const std::vector<uint32_t> &pixels) {
+    if (pixels.size() != width)
+        throw PngImageException("Error writing PNG image file: row of " + std::to_string(pixels.size()) + " pixels in an image " + std::to_string(width) + " wide");
+    if (rows == 0x7fffffff)
+        throw PngImageException("Error writing PNG image file: too many rows");
+
+    if (orientation == Orientation::Vertical) {
+        for (unsigned int x = 0; x < width; x++) {
+            row[PixelBytes * x] = static_cast<uint8_t>(pixels[x] >> 16);
+            row[PixelBytes * x + 1] = static_cast<uint8_t>(pixels[x] >> 8);
+            row[PixelBytes * x + 2] = static_cast<uint8_t>(pixels[x]);
+        }
+
+        filterRow([this](size_t index, const uint8_t *&segment, const uint8_t *&previous) -> size_t {
+            segment = row.data();
+            previous = previousRow.data();
+            return (index == 0) ? row.size() : 0;
+        });
+        row.swap(previousRow);
+    } else {
+        std::copy(pixels.begin(), pixels.end(), tile.begin() + static_cast<std::ptrdiff_t>(tileRows * width));
+        if (++tileRows == TileRows)
+            flushTile();
+    }
+
+    rows++;
+}
+
+void PngImageSink::write() {
+    if (rows == 0)
+        throw PngImageException("Error writing PNG image file: no rows");
+
+    if (orientation == Orientation::Horizontal) {
+        if (tileRows > 0)
+            flushTile();
+        encodeColumns();
+    } else {
+        imageHeight = rows;
+    }
+
+    submit(true);
+    while (writeBlock(true))
+        ;
+
+    data.clear();
+    writeChunk("IEND", data);
+
+    /* Patch the size into the header */
+    if (std::fseek(file, 8, SEEK_SET) != 0)
+        throw PngImageException("Error writing PNG image file: " + std::string(std::strerror(errno)));
+    writeHeader();
+
+    if (std::fflush(file) != 0)
+        throw PngImageException("Error writing PNG image file: " + std::string(std::strerror(errno)));
+}
+
+void PngImageSink::flushTile() {
+    transposeRows(tile.data(), tileRows, width, columns.data());
+
+    size_t pixels = tileRows * width;
+    for (size_t i = 0; i < pixels; i++) {
+        tilePixels[PixelBytes * i] = static_cast<uint8_t>(columns[i] >> 16);
+        tilePixels[PixelBytes * i + 1] = static_cast<uint8_t>(columns[i] >> 8);
+        tilePixels[PixelBytes * i + 2] = static_cast<uint8_t>(columns[i]);
+    }
+
+    if (std::fwrite(tilePixels.data(), 1, pixels * PixelBytes, scratch) != pixels * PixelBytes)
+        throw PngImageException("Error writing PNG image scratch file: " + std::string(std::strerror(errno)));
+
+    tileRows = 0;
+}
+
+void PngImageSink::encodeColumns() {
+    imageWidth = rows;
+
+    if (std::fflush(scratch) != 0)
+        throw PngImageException("Error writing PNG image scratch file: " + std::string(std::strerror(errno)));
+
+    size_t length = static_cast<size_t>(rows) * width * PixelBytes;
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno(scratch), 0);
+    if (mapping == MAP_FAILED)
+        throw PngImageException("Error mapping PNG image scratch file: " + std::string(std::strerror(errno)));
+
+    /* An image row is the same row of the columns of every tile, in turn,
+     * filtered straight from the mapping */
+    const uint8_t *tiles = static_cast<const uint8_t *>(mapping);
+    size_t tileBytes = TileRows * width * PixelBytes;
+    try {
+        for (size_t y = 0; y < width; y++) {
+            filterRow([&](size_t index, const uint8_t *&segment, const uint8_t *&previous) -> size_t {
+                size_t first = index * TileRows;
+                if (first >= rows)
+                    return 0;
+
+                size_t count = std::min<size_t>(TileRows, rows - first);
+                segment = tiles + index * tileBytes + y * count * PixelBytes;
+                previous = (y > 0) ? segment - count * PixelBytes : zeros.data();
+                return count * PixelBytes;
+            });
+        }
+    } catch (...) {
+        munmap(mapping, length);
+        throw;
+    }
+
+    munmap(mapping, length);
+}
+
+template <typename Segments>
+void PngImageSink::filterRow(Segments segment) {
+    static const uint8_t none[PixelBytes] = {0, 0, 0};
+    const uint8_t *part, *above;
+    size_t length;
+
+    /* Filter type of the smallest sum over the whole row */
+    unsigned long sums[5] = {0, 0, 0, 0, 0};
+    const uint8_t *left = none, *aboveLeft = none;
+    for (size_t i = 0; (length = segment(i, part, above)) > 0; i++) {
+        sumSegment(part, above, length, left, aboveLeft, sums);
+        left = part + length - PixelBytes;
+        aboveLeft = above + length - PixelBytes;
+    }
+
+    uint8_t type = static_cast<uint8_t>(std::min_element(sums, sums + 5) - sums);
+    put(&type, 1);
+
+    left = aboveLeft = none;
+    for (size_t i = 0; (length = segment(i, part, above)) > 0; i++) {
+        filterSegment(part, above, length, left, aboveLeft, type, filtered.data());
+        put(filtered.data(), length);
+        left = part + length - PixelBytes;
+        aboveLeft = above + length - PixelBytes;
+    }
+}
+
+void PngImageSink::put(const uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        size_t count = std::min(length, BlockBytes - current->length);
+        std::memcpy(current->bytes.data() + current->dictionary + current->length, bytes, count);
+        current->length += count;
+        bytes += count;
+        length -= count;
+
+        if (current->length == BlockBytes)
+            submit(false);
+    }
+}
+
+void PngImageSink::submit(bool last) {
+    Block *block = current;
+    block->last = last;
+    block->done = block->failed = false;
+    pending.push_back(block);
+
+    {
+        std::lock_guard<std::mutex> lg(lock);
+        queue.push_back(block);
+    }
+    queued.notify_one();
+
+    current = nullptr;
+    if (last)
+        return;
+
+    /* Write the blocks compressed, waiting for the oldest while none is free */
+    while (writeBlock(freeBlocks.empty()))
+        ;
+
+    current = freeBlocks.back();
+    freeBlocks.pop_back();
+
+    /* Window from the end of the block before, which may be this block
+     * again once written */
+    size_t window = std::min(WindowBytes, block->dictionary + block->length);
+    std::memmove(current->bytes.data(), block->bytes.data() + block->dictionary + block->length - window, window);
+    current->dictionary = window;
+    current->length = 0;
+}
+
+bool PngImageSink::writeBlock(bool wait) {
+    if (pending.empty())
+        return false;
+
+    Block *block = pending.front();
+    {
+        std::unique_lock<std::mutex> ul(lock);
+        if (!block->done && !wait)
+            return false;
+        compressed.wait(ul, [block] { return block->done; });
+    }
+
+    if (block->failed)
+        throw PngImageException("Error compressing PNG image file");
+
+    /* One zlib stream across the blocks: header first, adler-32 of all last */
+    data.clear();
+    if (!started) {
+        data.push_back(0x78);
+        data.push_back(0x9c);
+        started = true;
+    }
+    data.insert(data.end(), block->deflated.begin(), block->deflated.end());
+    adler = adler32_combine(adler, block->adler, static_cast<z_off_t>(block->length));
+    if (block->last) {
+        data.resize(data.size() + 4);
+        putUint32(data, data.size() - 4, adler);
+    }
+
+    writeChunk("IDAT", data);
+
+    pending.pop_front();
+    freeBlocks.push_back(block);
+    return true;
+}
+
+void PngImageSink::writeChunk(const char *type, const std::vector<uint8_t> &data) {
+    /* Length, type, data, and CRC of the type and data */
+    chunk.resize(12 + data.size());
+    putUint32(chunk, 0, data.size());
+    std::memcpy(chunk.data() + 4, type, 4);
+    std::copy(data.begin(), data.end(), chunk.begin() + 8);
+    putUint32(chunk, 8 + data.size(), crc32(0L, chunk.data() + 4, static_cast<uInt>(4 + data.size())));
+
+    if (std::fwrite(chunk.data(), 1, chunk.size(), file) != chunk.size())
+        throw PngImageException("Error writing PNG image file: " + std::string(std::strerror(errno)));
+}
+
+void PngImageSink::writeHeader() {
+    /* Width, height, 8-bit RGB, deflate, adaptive filtering, no interlace */
+    std::vector<uint8_t> header(13, 0);
+    putUint32(header, 0, imageWidth);
+    putUint32(header, 4, imageHeight);
+    header[8] = 8;
+    header[9] = 2;
+    writeChunk("IHDR", header);
+}
+
+void PngImageSink::run() {
+    /* A deflate stream per thread, reset for each block rather than made again */
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    bool initialized = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+
+    std::unique_lock<std::mutex> ul(lock);
+    while (true) {
+        queued.wait(ul, [this] { return stopping || !queue.empty(); });
+        if (stopping)
+            break;
+
+        Block *block = queue.front();
+        queue.pop_front();
+
+        ul.unlock();
+        block->failed = !initialized || deflateReset(&stream) != Z_OK;
+        if (!block->failed)
+            compress(*block, stream);
+        ul.lock();
+
+        block->done = true;
+        compressed.notify_all();
+    }
+
+    if (initialized)
+        deflateEnd(&stream);
+}
+
+void PngImageSink::compress(Block &block, z_stream &stream) {
+    /* The bytes before the block prime the window, the block's own are deflated */
+    uint8_t *input = block.bytes.data() + block.dictionary;
+    block.adler = adler32(adler32(0L, Z_NULL, 0), input, static_cast<uInt>(block.length));
+
+    if (block.dictionary > 0 && deflateSetDictionary(&stream, block.bytes.data(), static_cast<uInt>(block.dictionary)) != Z_OK)
+        block.failed = true;
+
+    /* Blocks but the last end on a byte boundary, to be followed by the next */
+    block.deflated.resize(deflateBound(&stream, block.length) + 16);
+    stream.next_in = input;
+    stream.avail_in = static_cast<uInt>(block.length);
+
+    size_t produced = 0;
+    while (!block.failed) {
+        stream.next_out = block.deflated.data() + produced;
+        stream.avail_out = static_cast<uInt>(block.deflated.size() - produced);
+        int ret = deflate(&stream, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+        produced = block.deflated.size() - stream.avail_out;
+
+        if (ret == Z_STREAM_ERROR)
+            block.failed = true;
+        else if (block.last ? (ret == Z_STREAM_END) : (stream.avail_out > 0))
+            break;
+        else
+            block.deflated.resize(2 * block.deflated.size());
+    }
+
+    block.deflated.resize(produced);
+}
+}
@@ -0,0 +1,121 @@
+#ifndef _PNGIMAGESINK_HPP
+#define _PNGIMAGESINK_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <cstdio>
+
+#include <zlib.h>
+
+#include "ImageSink.hpp"
+
+namespace Image {
+
+/* Streams rows of pixels to a PNG file as they are appended, so memory stays
+ * bounded however long the image, and encoding overlaps with rendering.
+ * Rows are filtered and deflated in blocks on a pool of threads, each block
+ * a deflate stream of its own primed with the rows before it, and written in
+ * order as IDAT chunks. Blocks are a fixed number of bytes, split across
+ * rows as needed, so memory doesn't depend on the width of a row either.
+ * The size is patched into the header once written, so the file must be
+ * seekable.
+ *
+ * Horizontal images are transposed a tile of rows at a time as they arrive,
+ * into a scratch file beside the image, and encoded from it once written. */
+class PngImageSink : public ImageSink {
+  public:
+    PngImageSink(std::string path, unsigned int width, Orientation orientation, unsigned int threadCount);
+    ~PngImageSink();
+
+    virtual void append(const std::vector<uint32_t> &pixels);
+    virtual void write();
+
+  private:
+    /* A slice of the filtered rows, a fixed number of bytes whatever the
+     * width of a row, after the bytes before it that prime the window */
+    struct Block {
+        std::vector<uint8_t> bytes;
+        size_t dictionary, length;
+        bool last;
+        /* Deflated bytes, and the adler-32 of the block's own */
+        std::vector<uint8_t> deflated;
+        unsigned long adler;
+        bool done, failed;
+    };
+
+    /* Transpose the tile of rows into the scratch file, and encode the
+     * image rows from it */
+    void flushTile();
+    void encodeColumns();
+
+    /* Filter a row with the filter of the smallest sum of differences, into
+     * the blocks. The row is read in segments, each segment(index, row,
+     * previous) pointing row and previous at a segment of the row and of
+     * the row above and returning its length, 0 past the last. */
+    template <typename Segments>
+    void filterRow(Segments segment);
+    /* Append filtered bytes to the blocks */
+    void put(const uint8_t *bytes, size_t length);
+
+    /* Deflate a block with a compression thread's stream */
+    void compress(Block &block, z_stream &stream);
+    void run();
+
+    /* Hand the current block to the compression threads */
+    void submit(bool last);
+    /* Write the oldest block once compressed, waiting for it with wait */
+    bool writeBlock(bool wait);
+    void writeChunk(const char *type, const std::vector<uint8_t> &data);
+    void writeHeader();
+
+    const std::string path;
+    /* Pixels of a row appended, and rows appended */
+    const unsigned int width;
+    const Orientation orientation;
+    unsigned int rows;
+    FILE *file;
+    unsigned int imageWidth, imageHeight;
+
+    /* Row appended and the row before it in RGB (vertical only), a segment
+     * filtered, and zeros above the first row */
+    std::vector<uint8_t> row, previousRow, filtered, zeros;
+
+    /* Blocks filling, compressing in order, and free */
+    Block *current;
+    std::deque<Block *> pending;
+    std::vector<Block *> freeBlocks;
+    std::vector<std::unique_ptr<Block>> blocks;
+
+    /* Tile of rows appended, its columns, and the RGB columns of the tiles
+     * transposed (horizontal only) */
+    std::vector<uint32_t> tile, columns;
+    std::vector<uint8_t> tilePixels;
+    size_t tileRows;
+    FILE *scratch;
+
+    /* Blocks waiting for a compression thread */
+    std::deque<Block *> queue;
+    std::vector<std::thread> threads;
+    bool stopping;
+    std::mutex lock;
+    std::condition_variable queued, compressed;
+
+    /* Deflate stream state across blocks, and a chunk being written */
+    bool started;
+    unsigned long adler;
+    std::vector<uint8_t> data, chunk;
+};
+
+class PngImageException : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include <cstring>
+#include <cerrno>
+
+#include "RawImageSink.hpp"
+
+namespace Image {
+
+RawImageSink::RawImageSink(std::string path) {
+    if (path == "-")
+        file = stdout;
+    else if ((file = std::fopen(path.c_str(), "wb")) == nullptr)
+        throw RawImageException("Error opening raw image file: " + std::string(std::strerror(errno)));
+}
+
+RawImageSink::~RawImageSink() {
+    if (file != stdout)
+        std::fclose(file);
+}
+
+void RawImageSink::append(const std::vector<uint32_t> &pixels) {
+    if (std::fwrite(pixels.data(), sizeof(uint32_t), pixels.size(), file) != pixels.size())
+        throw RawImageException("Error writing raw image file: " + std::string(std::strerror(errno)));
+
+    /* Hand every row on to the consumer as soon as it's rendered */
+    std::fflush(file);
+}
+
+void RawImageSink::write() {
+    if (std::fflush(file) != 0)
+        throw RawImageException("Error writing raw image file: " + std::string(std::strerror(errno)));
+}
+}
@@ -0,0 +1,33 @@
+#ifndef _RAWIMAGESINK_HPP
+#define _RAWIMAGESINK_HPP
+
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+
+#include "ImageSink.hpp"
+
+namespace Image {
+
+/* Writes rows of 32-bit BGRA pixels to a file or stdout ("-") as they are
+ * appended, in time order, so the output can be consumed while the audio
+ * is still arriving. */
+class RawImageSink : public ImageSink {
+  public:
+    RawImageSink(std::string path);
+    ~RawImageSink();
+
+    virtual void append(const std::vector<uint32_t> &pixels);
+    virtual void write();
+
+  private:
+    FILE *file;
+};
+
+class RawImageException : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Transpose.hpp"
+
+namespace Image {
+
+/* Pixels along each side of a block, so a block of rows and of columns both
+ * stay in cache */
+static const size_t BlockSize = 64;
+
+void transposeRows(const uint32_t *rows, size_t count, size_t width, uint32_t *columns) {
+    for (size_t r0 = 0; r0 < count; r0 += BlockSize) {
+        size_t r1 = std::min(r0 + BlockSize, count);
+
+        for (size_t x0 = 0; x0 < width; x0 += BlockSize) {
+            size_t x1 = std::min(x0 + BlockSize, width);
+            size_t r = r0;
+
+#ifdef __SSE2__
+            for (; r + 4 <= r1; r += 4) {
+                size_t x = x0;
+                for (; x + 4 <= x1; x += 4) {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + r * width + x));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + (r + 1) * width + x));
+                    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + (r + 2) * width + x));
+                    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows + (r + 3) * width + x));
+
+                    __m128i ab01 = _mm_unpacklo_epi32(a, b), cd01 = _mm_unpacklo_epi32(c, d);
+                    __m128i ab23 = _mm_unpackhi_epi32(a, b), cd23 = _mm_unpackhi_epi32(c, d);
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(columns + (width - 1 - x) * count + r), _mm_unpacklo_epi64(ab01, cd01));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(columns + (width - 2 - x) * count + r), _mm_unpackhi_epi64(ab01, cd01));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(columns + (width - 3 - x) * count + r), _mm_unpacklo_epi64(ab23, cd23));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(columns + (width - 4 - x) * count + r), _mm_unpackhi_epi64(ab23, cd23));
+                }
+
+                for (; x < x1; x++) {
+                    for (size_t k = 0; k < 4; k++)
+                        columns[(width - 1 - x) * count + r + k] = rows[(r + k) * width + x];
+                }
+            }
+#endif
+
+            for (; r < r1; r++) {
+                for (size_t x = x0; x < x1; x++)
+                    columns[(width - 1 - x) * count + r] = rows[r * width + x];
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,16 @@
+#ifndef _TRANSPOSE_HPP
+#define _TRANSPOSE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Image {
+
+/* Turn count rows of width pixels a quarter turn counterclockwise, into
+ * width rows of count pixels, the last column of the rows first (so low
+ * frequencies end up at the bottom). Transposed in cache sized blocks, four
+ * by four pixels at a time with SSE2. */
+void transposeRows(const uint32_t *rows, size_t count, size_t width, uint32_t *columns);
+}
+
+#endif
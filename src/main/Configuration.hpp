@@ -1,9 +1,15 @@
 #ifndef _CONFIGURATION_HPP
 #define _CONFIGURATION_HPP
 
+#include <string>
+#include <vector>
+
 #include "audio/AudioSource.hpp"
+#include "audio/ChannelMixer.hpp"
 #include "dft/RealDft.hpp"
 #include "spectrogram/SpectrumRenderer.hpp"
+#include "pipeline/BufferQueue.hpp"
+#include "pipeline/Realtime.hpp"
 
 using namespace DFT;
 using namespace Spectrogram;
@@ -13,6 +19,26 @@ namespace Configuration {
 enum class Orientation { Horizontal,
                          Vertical };
 
+/* How the pipeline stages are run: Auto picks thread per stage for realtime,
+ * and a single thread for files unless there are several DFT threads */
+enum class Executor { Auto,
+                      Single,
+                      ThreadPerStage,
+                      Pooled };
+
+/* Format of a stream input: Auto reads WAV files, and WAV streams from stdin
+ * or FIFOs, the others are headerless little-endian PCM */
+enum class InputFormat { Auto,
+                         Wav,
+                         S16,
+                         S32,
+                         F32 };
+
+/* How the spectrograms of several channels are laid out: side by side in
+ * one image, or in an image each (file mode only) */
+enum class ChannelLayout { Stacked,
+                           Separate };
+
 struct Settings {
     /* Interface Settings */
     unsigned int width = 640;
@@ -20,15 +46,83 @@ struct Settings {
     Orientation orientation = Orientation::Vertical;
     /* Audio Settings */
     unsigned int audioSampleRate = 24000;
+    unsigned int audioReadSize = 128;
+    unsigned int audioFragmentSize = 256;
+    /* Frames decoded per read ahead block in file mode */
+    unsigned int fileReadSize = 16384;
+    /* Range rendered in file mode: start in seconds, or in samples if set, and duration in seconds, or in samples if set (0 for the rest) */
+    double start = 0.0;
+    uint64_t startSample = 0;
+    double duration = 0.0;
+    uint64_t durationSamples = 0;
+    /* Threads rendering time chunks of a file in parallel, 0 for one per cpu */
+    unsigned int fileThreads = 0;
+    /* Threads compressing a PNG image as it is written, 0 for one per cpu */
+    unsigned int imageThreads = 0;
+    /* PulseAudio target latency in milliseconds, 0 for the fragment size */
+    unsigned int audioLatency = 0;
+    /* PulseAudio sources captured, each with an analysis chain of its own (the default source if none) */
+    std::vector<std::string> audioSources;
+    /* Stream input format, and channel count of raw streams */
+    InputFormat inputFormat = InputFormat::Auto;
+    unsigned int inputChannels = 1;
+    /* UDP input [address:]port for realtime mode instead of PulseAudio, and jitter buffer in milliseconds */
+    std::string udpAddress;
+    unsigned int udpJitter = 40;
+    /* File played back as realtime input instead of PulseAudio, at a speed (0 for as fast as possible), looping */
+    std::string playPath;
+    double playSpeed = 1.0;
+    bool playLoop = false;
+    /* Generated input signal instead of PulseAudio or a file, and its length in seconds (0 for no end) */
+    std::string generateSignal;
+    double generateSeconds = 0.0;
+    /* Channels analyzed, and the input channel in single channel mode */
+    Audio::ChannelMixer::Mode channelMode = Audio::ChannelMixer::Mode::All;
+    unsigned int channel = 0;
+    ChannelLayout channelLayout = ChannelLayout::Stacked;
     /* DFT Settings */
     float samplesOverlap = 0.50;
     unsigned int dftSize = 1024;
     RealDft::WindowFunction dftWf = RealDft::WindowFunction::Hann;
+    unsigned int dftThreads = 1;
+    /* Band analyzed, from bandStart Hz to the decimated Nyquist frequency, with a decimation above 1 */
+    double bandStart = 0.0;
+    unsigned int decimation = 1;
+    /* Frames in flight per DFT thread, when more than one */
+    unsigned int dftQueueDepth = 8;
     /* Spectrogram Settings */
     double magnitudeMin = 0.0;
     double magnitudeMax = 45.0;
     bool magnitudeLog = true;
     SpectrumRenderer::ColorScheme colors = SpectrumRenderer::ColorScheme::Heat;
+    /* Pipeline Settings (samples queue capacity in samples, pixels queue capacity in rows) */
+    size_t samplesQueueCapacity = 262144;
+    QueuePolicy samplesQueuePolicy = QueuePolicy::DropOldest;
+    size_t pixelsQueueCapacity = 1024;
+    QueuePolicy pixelsQueuePolicy = QueuePolicy::Coalesce;
+    Executor executor = Executor::Auto;
+    /* Pooled executor threads, 0 for one per cpu */
+    unsigned int executorThreads = 0;
+    /* Load Shedding Settings (bounds on how far work is shed under load) */
+    bool loadShedding = true;
+    float loadSheddingOverlapMin = 0.05f;
+    unsigned int loadSheddingSkipMax = 4;
+    unsigned int loadSheddingPixelStepMax = 4;
+    /* Seconds of samples kept in realtime mode, for a region of a frozen
+     * display to be analyzed again (0 for none), and the DFT size it is
+     * analyzed with */
+    double historySeconds = 0.0;
+    unsigned int regionDftSize = 8192;
+    /* Print read ahead and timing statistics after rendering a file */
+    bool stats = false;
+    /* Latency Settings (scheduling and memory locking only in latency mode) */
+    bool latencyMode = false;
+    Realtime::Scheduler latencyScheduler = Realtime::Scheduler::Fifo;
+    int audioPriority = 70;
+    int dftPriority = 60;
+    int audioCpu = -1;
+    int dftCpu = -1;
+    int interfaceCpu = -1;
     /* Initial settings when switching between logarithmic/linear in UI */
     double magnitudeLogMin = 0.0;
     double magnitudeLogMax = 50.0;
@@ -48,6 +142,39 @@ struct Limits {
     /* DFT size min, max */
     unsigned int dftSizeMin = 64;
     unsigned int dftSizeMax = 8192;
+    /* Region analysis DFT size max */
+    unsigned int regionDftSizeMax = 65536;
+    /* Sample history max, in seconds */
+    double historySecondsMax = 3600.0;
+    /* File read ahead block max, in frames */
+    unsigned int fileReadSizeMax = 1048576;
+    /* File chunk threads max, and rows of a chunk rendered in parallel */
+    unsigned int fileThreadsMax = 64;
+    unsigned int fileChunkRows = 4096;
+    /* PNG image compression threads max */
+    unsigned int imageThreadsMax = 64;
+    /* DFT threads max */
+    unsigned int dftThreadsMax = 64;
+    /* Band decimation max */
+    unsigned int decimationMax = 64;
+    /* Raw stream input channels max */
+    unsigned int inputChannelsMax = 64;
+    /* PulseAudio sources captured at once max */
+    unsigned int audioSourcesMax = 16;
+    /* UDP jitter buffer max, in milliseconds */
+    unsigned int udpJitterMax = 2000;
+    /* Playback speed max, as a multiple of real-time */
+    double playSpeedMax = 1000.0;
+    /* Generated input length for an image, when not set */
+    double generateSecondsImage = 10.0;
+    /* Pooled executor threads max */
+    unsigned int executorThreadsMax = 64;
+    /* Load shedding frame skip max, pixel step max */
+    unsigned int loadSheddingSkipMax = 16;
+    unsigned int loadSheddingPixelStepMax = 16;
+    /* Latency mode scheduler priority min, max */
+    int schedulerPriorityMin = 1;
+    int schedulerPriorityMax = 99;
     /* Samples overlap min, max, step */
     float samplesOverlapMin = 0.05f;
     float samplesOverlapMax = 0.95f;
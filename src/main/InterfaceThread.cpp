@@ -3,6 +3,7 @@
 #include <sstream>
 #include <algorithm>
 #include <map>
+#include <cinttypes>
 
 #include <iostream>
 
@@ -29,6 +30,12 @@ static const std::vector<std::string> FontFilesSearch = {
 
 static std::map<std::string, std::string> FontFilesAvailable;
 
+/* Position of a row not shown yet */
+static const uint64_t NoPosition = ~static_cast<uint64_t>(0);
+
+/* Audio sample rates stepped through */
+static const unsigned int SampleRates[] = {8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000, 192000};
+
 static int fontCrawlCallback(const char *fpath, const struct stat *sb, int typeflag) {
     (void)sb;
 
@@ -65,7 +72,41 @@ static std::string findFontPath() {
     return "";
 }
 
-InterfaceThread::InterfaceThread(ThreadSafeQueue<std::vector<uint32_t>> &pixelsQueue, AudioThread &audioThread, SpectrogramThread &spectrogramThread, const Settings &initialSettings) : pixelsQueue(pixelsQueue), audioThread(audioThread), spectrogramThread(spectrogramThread), width(initialSettings.width), height(initialSettings.height), orientation(initialSettings.orientation), hideInfo(false), hideStatistics(true) {
+void InterfaceThread::getTileGrid(size_t tiles, Orientation orientation, unsigned int &columns, unsigned int &rows) {
+    /* Smallest square grid that fits, shortened along the time axis */
+    unsigned int across = 1;
+    while (static_cast<size_t>(across) * across < tiles)
+        across++;
+    unsigned int along = static_cast<unsigned int>((tiles + across - 1) / across);
+
+    columns = (orientation == Orientation::Vertical) ? across : along;
+    rows = (orientation == Orientation::Vertical) ? along : across;
+}
+
+InterfaceThread::InterfaceThread(const std::vector<SpectrogramPipeline *> &spectrogramPipelines, const std::vector<std::string> &names, const Settings &initialSettings) : selected(0), width(initialSettings.width), height(initialSettings.height), orientation(initialSettings.orientation), channels(spectrogramPipelines.front()->getChannels()), bandStart(spectrogramPipelines.front()->getBandStart()), decimation(spectrogramPipelines.front()->getDecimation()), hideInfo(false), hideStatistics(true), switchingSampleRate(0), frozen(false), selecting(false), selectionTile(0), selectionBegin(0), selectionEnd(0), regionDftSize(initialSettings.regionDftSize), regionWf(initialSettings.dftWf), regionSettings(initialSettings), regionBegin(0), regionShown(false), latencyMode(initialSettings.latencyMode), audioReadSize(initialSettings.audioReadSize), audioFragmentSize(initialSettings.audioFragmentSize), lastStatistics() {
+    threadSettings.cpu = initialSettings.interfaceCpu;
+
+    getTileGrid(spectrogramPipelines.size(), orientation, columns, rows);
+
+    /* Tiles fill the grid row by row */
+    tiles.resize(spectrogramPipelines.size());
+    for (size_t i = 0; i < tiles.size(); i++) {
+        Tile &tile = tiles[i];
+        tile.pipeline = spectrogramPipelines[i];
+        tile.pixelsQueue = &spectrogramPipelines[i]->getPixelsQueue();
+        tile.name = (i < names.size()) ? names[i] : "";
+        tile.pixels.reset(new uint32_t[width * height]);
+        tile.centers.assign((orientation == Orientation::Vertical) ? height : width, NoPosition);
+        tile.pixelsTexture = nullptr;
+        tile.rect.x = static_cast<int>((i % columns) * width);
+        tile.rect.y = static_cast<int>((i / columns) * height);
+        tile.rect.w = static_cast<int>(width);
+        tile.rect.h = static_cast<int>(height);
+        tile.nameTexture = nullptr;
+        tile.displayLatency = 0;
+        tile.sampleRate = tile.pipeline->getSampleRate();
+    }
+
     int ret;
 
     /* Initialize SDL */
@@ -79,7 +120,7 @@ InterfaceThread::InterfaceThread(ThreadSafeQueue<std::vector<uint32_t>> &pixelsQ
         throw TTFException("Unable to initialize TTF: TTF_Init(): " + std::string(TTF_GetError()));
 
     /* Create Window */
-    win = SDL_CreateWindow("audioprism", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, static_cast<int>(width), static_cast<int>(height), SDL_WINDOW_OPENGL);
+    win = SDL_CreateWindow("audioprism", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, static_cast<int>(width * columns), static_cast<int>(height * rows), SDL_WINDOW_OPENGL);
     if (win == nullptr)
         throw SDLException("Creating SDL window: SDL_CreateWindow(): " + std::string(SDL_GetError()));
 
@@ -88,10 +129,12 @@ InterfaceThread::InterfaceThread(ThreadSafeQueue<std::vector<uint32_t>> &pixelsQ
     if (renderer == nullptr)
         throw SDLException("Creating SDL renderer: SDL_CreateRenderer(): " + std::string(SDL_GetError()));
 
-    /* Create main texture */
-    pixelsTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_STATIC, static_cast<int>(width), static_cast<int>(height));
-    if (pixelsTexture == nullptr)
-        throw SDLException("Creating SDL texture: SDL_CreateTexture(): " + std::string(SDL_GetError()));
+    /* Create a texture per tile */
+    for (Tile &tile : tiles) {
+        tile.pixelsTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_STATIC, static_cast<int>(width), static_cast<int>(height));
+        if (tile.pixelsTexture == nullptr)
+            throw SDLException("Creating SDL texture: SDL_CreateTexture(): " + std::string(SDL_GetError()));
+    }
 
     statisticsTexture = nullptr;
     settingsTexture = nullptr;
@@ -106,12 +149,20 @@ InterfaceThread::InterfaceThread(ThreadSafeQueue<std::vector<uint32_t>> &pixelsQ
     font = TTF_OpenFont(fontPath.c_str(), 11);
     if (font == nullptr)
         throw TTFException("Opening TTF font: TTF_OpenFont(): " + std::string(TTF_GetError()));
+
+    /* Label tiles with their names, when there are several */
+    if (tiles.size() > 1)
+        renderNames();
 }
 
 InterfaceThread::~InterfaceThread() {
     TTF_CloseFont(font);
-    if (pixelsTexture)
-        SDL_DestroyTexture(pixelsTexture);
+    for (Tile &tile : tiles) {
+        if (tile.pixelsTexture)
+            SDL_DestroyTexture(tile.pixelsTexture);
+        if (tile.nameTexture)
+            SDL_DestroyTexture(tile.nameTexture);
+    }
     if (settingsTexture)
         SDL_DestroyTexture(settingsTexture);
     if (cursorTexture)
@@ -124,7 +175,17 @@ InterfaceThread::~InterfaceThread() {
     SDL_Quit();
 }
 
-static std::string format(const char *fmt, ...) {
+SpectrogramPipeline &InterfaceThread::spectrogramPipeline() {
+    return *tiles[selected].pipeline;
+}
+
+template <typename Function>
+void InterfaceThread::forEachPipeline(Function function) {
+    for (Tile &tile : tiles)
+        function(*tile.pipeline);
+}
+
+__attribute__((format(printf, 1, 2))) static std::string format(const char *fmt, ...) {
     char buf[64];
     va_list ap;
     va_start(ap, fmt);
@@ -193,14 +254,14 @@ static SDL_Surface *vcatSurfaces(std::vector<SDL_Surface *> surfaces, Alignment
 }
 
 void InterfaceThread::updateSettings() {
-    settings.audioSampleRate = audioThread.getSampleRate();
-    settings.samplesOverlap = spectrogramThread.getSamplesOverlap();
-    settings.dftSize = spectrogramThread.getDftSize();
-    settings.dftWf = spectrogramThread.getDftWindowFunction();
-    settings.magnitudeMin = spectrogramThread.getMagnitudeMin();
-    settings.magnitudeMax = spectrogramThread.getMagnitudeMax();
-    settings.magnitudeLog = spectrogramThread.getMagnitudeLog();
-    settings.colors = spectrogramThread.getColors();
+    settings.audioSampleRate = tiles[selected].sampleRate;
+    settings.samplesOverlap = spectrogramPipeline().getSamplesOverlap();
+    settings.dftSize = spectrogramPipeline().getDftSize();
+    settings.dftWf = spectrogramPipeline().getDftWindowFunction();
+    settings.magnitudeMin = spectrogramPipeline().getMagnitudeMin();
+    settings.magnitudeMax = spectrogramPipeline().getMagnitudeMax();
+    settings.magnitudeLog = spectrogramPipeline().getMagnitudeLog();
+    settings.colors = spectrogramPipeline().getColors();
 }
 
 void InterfaceThread::renderSettings() {
@@ -210,7 +271,14 @@ void InterfaceThread::renderSettings() {
 
     unsigned int overlap = static_cast<unsigned int>(settings.samplesOverlap * 100.0);
 
-    textSurfaces.push_back(renderString(format("Sample Rate: %d Hz", settings.audioSampleRate), font, settingsColor));
+    if (tiles.size() > 1)
+        textSurfaces.push_back(renderString("Source: " + tiles[selected].name, font, settingsColor));
+    if (switchingSampleRate > 0)
+        textSurfaces.push_back(renderString(format("Sample Rate: %d Hz, switching to %d Hz", settings.audioSampleRate, switchingSampleRate), font, settingsColor));
+    else
+        textSurfaces.push_back(renderString(format("Sample Rate: %d Hz", settings.audioSampleRate), font, settingsColor));
+    if (decimation > 1)
+        textSurfaces.push_back(renderString(format("Band: %.0f - %.0f Hz", bandStart, bandStart + settings.audioSampleRate / 2.0), font, settingsColor));
     textSurfaces.push_back(renderString(format("Overlap: %d%%", overlap), font, settingsColor));
     textSurfaces.push_back(renderString("Window: " + to_string(settings.dftWf), font, settingsColor));
     textSurfaces.push_back(renderString(format("DFT Size: %d", settings.dftSize), font, settingsColor));
@@ -225,10 +293,17 @@ void InterfaceThread::renderSettings() {
         textSurfaces.push_back(renderString(format("Mag. Linear"), font, settingsColor));
     }
 
+    if (frozen) {
+        textSurfaces.push_back(renderString("Frozen", font, settingsColor));
+        textSurfaces.push_back(renderString(format("Region DFT: %d, ", regionDftSize) + to_string(regionWf), font, settingsColor));
+        if (!regionStatus.empty())
+            textSurfaces.push_back(renderString("Region: " + regionStatus, font, settingsColor));
+    }
+
     settingsSurface = vcatSurfaces(textSurfaces, Alignment::Right);
 
     /* Update settings rectangle destination for screen rendering */
-    settingsRect.x = static_cast<int>(width) - settingsSurface->w - 5;
+    settingsRect.x = static_cast<int>(width * columns) - settingsSurface->w - 5;
     settingsRect.y = 2;
     settingsRect.w = settingsSurface->w;
     settingsRect.h = settingsSurface->h;
@@ -251,20 +326,39 @@ void InterfaceThread::renderCursor(int x, int y) {
 
     float frequency;
 
+    /* Select the tile under the cursor, and take the cursor into it */
+    size_t tile = std::min<size_t>(static_cast<size_t>(std::max(y, 0)) / height * columns + static_cast<size_t>(std::max(x, 0)) / width, tiles.size() - 1);
+    if (tile != selected) {
+        selected = tile;
+        settings.audioSampleRate = tiles[selected].sampleRate;
+        /* Allocation deltas from the new tile's own counts */
+        lastStatistics.audioAllocations = spectrogramPipeline().getDebugAudioAllocations();
+        lastStatistics.spectrogramAllocations = spectrogramPipeline().getDebugDftAllocations();
+        renderSettings();
+        if (!hideStatistics)
+            renderStatistics();
+    }
+
     float hzPerBin = ((static_cast<float>(settings.audioSampleRate)) / 2.0f) / static_cast<float>((settings.dftSize / 2 + 1));
 
+    x -= tiles[selected].rect.x;
+    y -= tiles[selected].rect.y;
+
+    /* Frequency axis of the channel under the cursor */
     if (orientation == Orientation::Vertical) {
-        float binPerPixel = static_cast<float>((settings.dftSize / 2 + 1)) / static_cast<float>(width);
-        frequency = std::floor(static_cast<float>(x) * binPerPixel) * hzPerBin;
+        unsigned int lane = width / channels;
+        float binPerPixel = static_cast<float>((settings.dftSize / 2 + 1)) / static_cast<float>(lane);
+        frequency = std::floor(static_cast<float>(static_cast<unsigned int>(x) % lane) * binPerPixel) * hzPerBin;
     } else {
-        float binPerPixel = static_cast<float>((settings.dftSize / 2 + 1)) / static_cast<float>(height);
-        frequency = std::floor(static_cast<float>(static_cast<int>(height) - y) * binPerPixel) * hzPerBin;
+        unsigned int lane = height / channels;
+        float binPerPixel = static_cast<float>((settings.dftSize / 2 + 1)) / static_cast<float>(lane);
+        frequency = std::floor(static_cast<float>(static_cast<unsigned int>(static_cast<int>(height) - y) % lane) * binPerPixel) * hzPerBin;
     }
 
-    cursorSurface = renderString(format("%.0f Hz", frequency), font, settingsColor);
+    cursorSurface = renderString(format("%.0f Hz", bandStart + frequency), font, settingsColor);
 
     /* Update cursor rectangle destination for screen rendering */
-    cursorRect.x = static_cast<int>(width) - cursorSurface->w - 5;
+    cursorRect.x = static_cast<int>(width * columns) - cursorSurface->w - 5;
     cursorRect.y = settingsRect.y + settingsRect.h + cursorSurface->h;
     cursorRect.w = cursorSurface->w;
     cursorRect.h = cursorSurface->h;
@@ -286,15 +380,59 @@ void InterfaceThread::renderStatistics() {
     SDL_Surface *statisticsSurface;
     SDL_Color statisticsColor = {0xff, 0x00, 0x00, 0x00};
 
-    size_t samplesQueueCount = spectrogramThread.getDebugSamplesQueueCount();
+    size_t audioOverflows = spectrogramPipeline().getDebugAudioOverflows();
+    size_t audioUnderflows = spectrogramPipeline().getDebugAudioUnderflows();
+    size_t audioSamplesLost = spectrogramPipeline().getDebugAudioSamplesLost();
+    unsigned int audioLatency = spectrogramPipeline().getDebugAudioLatency();
+    size_t samplesQueueCount = spectrogramPipeline().getDebugSamplesQueueCount();
+    size_t samplesDropped = spectrogramPipeline().getDebugSamplesDropped();
+    BufferQueue<uint32_t> &pixelsQueue = *tiles[selected].pixelsQueue;
+    unsigned int displayLatency = tiles[selected].displayLatency;
     size_t pixelsQueueCount = pixelsQueue.count();
-
-    textSurfaces.push_back(renderString(format("Audio Queue: %u", samplesQueueCount), font, statisticsColor));
-    textSurfaces.push_back(renderString(format("Pixels Queue: %u", pixelsQueueCount), font, statisticsColor));
+    size_t framesQueued = spectrogramPipeline().getDebugFramesQueued();
+    size_t dftThreads = spectrogramPipeline().getDebugDftThreads();
+    unsigned int loadLevel = spectrogramPipeline().getDebugLoadLevel();
+    unsigned int loadLevels = spectrogramPipeline().getDebugLoadLevels();
+    unsigned int loadUtilization = spectrogramPipeline().getDebugLoadUtilization();
+    unsigned int loadBacklog = spectrogramPipeline().getDebugLoadBacklog();
+    LoadController::Degradation degradation = spectrogramPipeline().getDebugLoadDegradation();
+    unsigned int degradedOverlap = static_cast<unsigned int>(100.0 * static_cast<double>(degradation.samplesOverlap) / static_cast<double>(settings.dftSize));
+    size_t pixelsDropped = pixelsQueue.getDroppedBuffers();
+    size_t audioAllocations = spectrogramPipeline().getDebugAudioAllocations();
+    size_t spectrogramAllocations = spectrogramPipeline().getDebugDftAllocations();
+    uint64_t settingsVersion = spectrogramPipeline().getDebugSettingsVersion();
+    size_t settingsContention = spectrogramPipeline().getDebugSettingsContention();
+
+    textSurfaces.push_back(renderString(format("Latency: %u ms (audio %u ms)", displayLatency, audioLatency), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Audio: %zu overflows, %zu underflows", audioOverflows, audioUnderflows), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Lost Samples: %zu", audioSamplesLost), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Audio Queue: %zu", samplesQueueCount), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Pixels Queue: %zu", pixelsQueueCount), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("DFT Frames: %zu (%zu threads)", framesQueued, dftThreads), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Load: %u%%, %u ms behind", loadUtilization, loadBacklog), font, statisticsColor));
+    if (loadLevel > 0)
+        textSurfaces.push_back(renderString(format("Shedding %u/%u: overlap %u%%, 1 in %u frames, pixel step %u", loadLevel, loadLevels, degradedOverlap, degradation.skip, degradation.pixelStep), font, statisticsColor));
+    else
+        textSurfaces.push_back(renderString(format("Shedding 0/%u: full quality", loadLevels), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Dropped Samples: %zu", samplesDropped), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Dropped Rows: %zu", pixelsDropped), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Audio Allocs: %zu (+%zu)", audioAllocations, audioAllocations - lastStatistics.audioAllocations), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("DFT Allocs: %zu (+%zu)", spectrogramAllocations, spectrogramAllocations - lastStatistics.spectrogramAllocations), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Settings: v%" PRIu64 " (%zu contended)", settingsVersion, settingsContention), font, statisticsColor));
+    textSurfaces.push_back(renderString(format("Read/Fragment: %u/%u samples", audioReadSize, audioFragmentSize), font, statisticsColor));
+    textSurfaces.push_back(renderString("Executor: " + spectrogramPipeline().getDebugExecutor(), font, statisticsColor));
+    textSurfaces.push_back(renderString("Audio Thread: " + spectrogramPipeline().getDebugAudioThreadSettings(), font, statisticsColor));
+    textSurfaces.push_back(renderString("DFT Thread: " + spectrogramPipeline().getDebugDftThreadSettings(), font, statisticsColor));
+    textSurfaces.push_back(renderString("UI Thread: " + effectiveThreadSettings, font, statisticsColor));
+    if (latencyMode)
+        textSurfaces.push_back(renderString("Memory: " + effectiveMemoryLock, font, statisticsColor));
     statisticsSurface = vcatSurfaces(textSurfaces, Alignment::Right);
 
+    lastStatistics.audioAllocations = audioAllocations;
+    lastStatistics.spectrogramAllocations = spectrogramAllocations;
+
     /* Update statistics rectangle destination for screen rendering */
-    statisticsRect.x = static_cast<int>(width) - statisticsSurface->w - 5;
+    statisticsRect.x = static_cast<int>(width * columns) - statisticsSurface->w - 5;
     statisticsRect.y = cursorRect.y + cursorRect.h * 2;
     statisticsRect.w = statisticsSurface->w;
     statisticsRect.h = statisticsSurface->h;
@@ -314,6 +452,49 @@ void InterfaceThread::renderStatistics() {
 void InterfaceThread::handleKeyDown(const uint8_t *state) {
     if (state[SDL_SCANCODE_Q]) {
         running = false;
+    } else if (state[SDL_SCANCODE_F]) {
+        /* Freeze/unfreeze display, dropping the region analyzed */
+        frozen = !frozen;
+        if (!frozen) {
+            regionAnalysis.reset();
+            selecting = false;
+            regionStatus = "";
+        }
+    } else if (state[SDL_SCANCODE_W] && frozen) {
+        /* Change region window function */
+        if (regionWf == RealDft::WindowFunction::Hann)
+            regionWf = RealDft::WindowFunction::Hamming;
+        else if (regionWf == RealDft::WindowFunction::Hamming)
+            regionWf = RealDft::WindowFunction::Bartlett;
+        else if (regionWf == RealDft::WindowFunction::Bartlett)
+            regionWf = RealDft::WindowFunction::Rectangular;
+        else if (regionWf == RealDft::WindowFunction::Rectangular)
+            regionWf = RealDft::WindowFunction::Hann;
+    } else if (state[SDL_SCANCODE_RIGHT] && frozen) {
+        /* Region DFT N up */
+        regionDftSize = std::min<unsigned int>(regionDftSize * 2, UserLimits.regionDftSizeMax);
+    } else if (state[SDL_SCANCODE_LEFT] && frozen) {
+        /* Region DFT N down */
+        regionDftSize = std::max<unsigned int>(regionDftSize / 2, UserLimits.dftSizeMin);
+    } else if (state[SDL_SCANCODE_COMMA] || state[SDL_SCANCODE_PERIOD]) {
+        /* Audio sample rate down or up to the next standard rate */
+        unsigned int sampleRate = spectrogramPipeline().getAudioSampleRate();
+        unsigned int next_sampleRate = 0;
+        for (unsigned int rate : SampleRates) {
+            if (state[SDL_SCANCODE_COMMA] && rate < sampleRate)
+                next_sampleRate = rate;
+            else if (state[SDL_SCANCODE_PERIOD] && rate > sampleRate && next_sampleRate == 0)
+                next_sampleRate = rate;
+        }
+        if (next_sampleRate == 0)
+            return;
+
+        bool switched = false;
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { switched = pipeline.setAudioSampleRate(next_sampleRate) || switched; });
+        if (!switched)
+            return;
+
+        switchingSampleRate = next_sampleRate / decimation;
     } else if (state[SDL_SCANCODE_C]) {
         /* Change color scheme */
         SpectrumRenderer::ColorScheme next_colors = SpectrumRenderer::ColorScheme::Heat;
@@ -325,8 +506,8 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         else if (settings.colors == SpectrumRenderer::ColorScheme::Grayscale)
             next_colors = SpectrumRenderer::ColorScheme::Heat;
 
-        spectrogramThread.setColors(next_colors);
-        settings.colors = spectrogramThread.getColors();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setColors(next_colors); });
+        settings.colors = spectrogramPipeline().getColors();
     } else if (state[SDL_SCANCODE_W]) {
         /* Change window function */
         RealDft::WindowFunction next_wf = RealDft::WindowFunction::Hann;
@@ -340,34 +521,34 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         else if (settings.dftWf == RealDft::WindowFunction::Rectangular)
             next_wf = RealDft::WindowFunction::Hann;
 
-        spectrogramThread.setDftWindowFunction(next_wf);
-        settings.dftWf = spectrogramThread.getDftWindowFunction();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setDftWindowFunction(next_wf); });
+        settings.dftWf = spectrogramPipeline().getDftWindowFunction();
     } else if (state[SDL_SCANCODE_L]) {
         /* Toggle between Logarithimic/Linear */
         bool next_magnitudeLog = !settings.magnitudeLog;
 
-        spectrogramThread.setMagnitudeLog(next_magnitudeLog);
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeLog(next_magnitudeLog); });
         settings.magnitudeLog = next_magnitudeLog;
         if (next_magnitudeLog) {
-            spectrogramThread.setMagnitudeMin(InitialSettings.magnitudeLogMin);
-            spectrogramThread.setMagnitudeMax(InitialSettings.magnitudeLogMax);
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMin(InitialSettings.magnitudeLogMin); });
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMax(InitialSettings.magnitudeLogMax); });
         } else {
-            spectrogramThread.setMagnitudeMin(InitialSettings.magnitudeLinearMin);
-            spectrogramThread.setMagnitudeMax(InitialSettings.magnitudeLinearMax);
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMin(InitialSettings.magnitudeLinearMin); });
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMax(InitialSettings.magnitudeLinearMax); });
         }
-        settings.magnitudeMin = spectrogramThread.getMagnitudeMin();
-        settings.magnitudeMax = spectrogramThread.getMagnitudeMax();
+        settings.magnitudeMin = spectrogramPipeline().getMagnitudeMin();
+        settings.magnitudeMax = spectrogramPipeline().getMagnitudeMax();
     } else if (state[SDL_SCANCODE_RIGHT]) {
         /* DFT N up */
         unsigned int next_dftSize = std::min<unsigned int>(settings.dftSize * 2, UserLimits.dftSizeMax);
 
         if (next_dftSize != settings.dftSize) {
-            spectrogramThread.setDftSize(next_dftSize);
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setDftSize(next_dftSize); });
             /* Reset samples overlap to 50% */
-            spectrogramThread.setSamplesOverlap(0.50);
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setSamplesOverlap(0.50); });
 
-            settings.dftSize = spectrogramThread.getDftSize();
-            settings.samplesOverlap = spectrogramThread.getSamplesOverlap();
+            settings.dftSize = spectrogramPipeline().getDftSize();
+            settings.samplesOverlap = spectrogramPipeline().getSamplesOverlap();
         }
     } else if (state[SDL_SCANCODE_LEFT]) {
         /* DFT N down */
@@ -375,25 +556,25 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
 
         /* Set Samples Overlap for 50% overlap */
         if (next_dftSize != settings.dftSize) {
-            spectrogramThread.setDftSize(next_dftSize);
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setDftSize(next_dftSize); });
             /* Reset samples overlap to 50% */
-            spectrogramThread.setSamplesOverlap(0.50);
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setSamplesOverlap(0.50); });
 
-            settings.dftSize = spectrogramThread.getDftSize();
-            settings.samplesOverlap = spectrogramThread.getSamplesOverlap();
+            settings.dftSize = spectrogramPipeline().getDftSize();
+            settings.samplesOverlap = spectrogramPipeline().getSamplesOverlap();
         }
     } else if (state[SDL_SCANCODE_DOWN]) {
         /* Samples Overlap Up */
         float next_samplesOverlap = std::max<float>(settings.samplesOverlap - UserLimits.samplesOverlapStep, UserLimits.samplesOverlapMin);
 
-        spectrogramThread.setSamplesOverlap(next_samplesOverlap);
-        settings.samplesOverlap = spectrogramThread.getSamplesOverlap();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setSamplesOverlap(next_samplesOverlap); });
+        settings.samplesOverlap = spectrogramPipeline().getSamplesOverlap();
     } else if (state[SDL_SCANCODE_UP]) {
         /* Samples Overlap Down */
         float next_samplesOverlap = std::min<float>(settings.samplesOverlap + UserLimits.samplesOverlapStep, UserLimits.samplesOverlapMax);
 
-        spectrogramThread.setSamplesOverlap(next_samplesOverlap);
-        settings.samplesOverlap = spectrogramThread.getSamplesOverlap();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setSamplesOverlap(next_samplesOverlap); });
+        settings.samplesOverlap = spectrogramPipeline().getSamplesOverlap();
     } else if (state[SDL_SCANCODE_MINUS]) {
         /* Magnitude min down */
         double next_magnitudeMin;
@@ -403,8 +584,8 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         else
             next_magnitudeMin = std::max<double>(settings.magnitudeMin - UserLimits.magnitudeLinearStep, UserLimits.magnitudeLinearMin);
 
-        spectrogramThread.setMagnitudeMin(next_magnitudeMin);
-        settings.magnitudeMin = spectrogramThread.getMagnitudeMin();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMin(next_magnitudeMin); });
+        settings.magnitudeMin = spectrogramPipeline().getMagnitudeMin();
     } else if (state[SDL_SCANCODE_EQUALS]) {
         /* Magnitude min up */
         double next_magnitudeMin;
@@ -414,8 +595,8 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         else
             next_magnitudeMin = std::min<double>(settings.magnitudeMin + UserLimits.magnitudeLinearStep, settings.magnitudeMax - UserLimits.magnitudeLinearStep);
 
-        spectrogramThread.setMagnitudeMin(next_magnitudeMin);
-        settings.magnitudeMin = spectrogramThread.getMagnitudeMin();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMin(next_magnitudeMin); });
+        settings.magnitudeMin = spectrogramPipeline().getMagnitudeMin();
     } else if (state[SDL_SCANCODE_LEFTBRACKET]) {
         /* Magnitude max down */
         double next_magnitudeMax;
@@ -425,8 +606,8 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         else
             next_magnitudeMax = std::max<double>(settings.magnitudeMax - UserLimits.magnitudeLinearStep, settings.magnitudeMin + UserLimits.magnitudeLinearStep);
 
-        spectrogramThread.setMagnitudeMax(next_magnitudeMax);
-        settings.magnitudeMax = spectrogramThread.getMagnitudeMax();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMax(next_magnitudeMax); });
+        settings.magnitudeMax = spectrogramPipeline().getMagnitudeMax();
     } else if (state[SDL_SCANCODE_RIGHTBRACKET]) {
         /* Magnitude max up */
         double next_magnitudeMax;
@@ -436,8 +617,8 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         else
             next_magnitudeMax = std::min<double>(settings.magnitudeMax + UserLimits.magnitudeLinearStep, UserLimits.magnitudeLinearMax);
 
-        spectrogramThread.setMagnitudeMax(next_magnitudeMax);
-        settings.magnitudeMax = spectrogramThread.getMagnitudeMax();
+        forEachPipeline([&](SpectrogramPipeline &pipeline) { pipeline.setMagnitudeMax(next_magnitudeMax); });
+        settings.magnitudeMax = spectrogramPipeline().getMagnitudeMax();
     } else if (state[SDL_SCANCODE_H]) {
         /* Hide info */
         hideInfo = !hideInfo;
@@ -454,19 +635,130 @@ void InterfaceThread::handleKeyDown(const uint8_t *state) {
         return;
     }
 
+    /* Analyze the region again with the new settings */
+    if (frozen && regionAnalysis)
+        startRegionAnalysis();
+
+    renderSettings();
+}
+
+unsigned int InterfaceThread::rowAt(const Tile &tile, int x, int y) {
+    if (orientation == Orientation::Vertical)
+        return static_cast<unsigned int>(std::min(std::max(y - tile.rect.y, 0), static_cast<int>(height) - 1));
+    else
+        return static_cast<unsigned int>(std::min(std::max(x - tile.rect.x, 0), static_cast<int>(width) - 1));
+}
+
+void InterfaceThread::drawRow(Tile &tile, unsigned int index, const uint32_t *row) {
+    if (orientation == Orientation::Vertical) {
+        memcpy(tile.pixels.get() + index * width, row, width * sizeof(uint32_t));
+    } else {
+        /* Rows are columns, low frequencies at the bottom */
+        for (unsigned int y = 0; y < height; y++)
+            tile.pixels[(height - 1 - y) * width + index] = row[y];
+    }
+}
+
+void InterfaceThread::startRegionAnalysis() {
+    Tile &tile = tiles[selectionTile];
+
+    /* Stop an analysis still running */
+    regionAnalysis.reset();
+    regionShown = false;
+
+    Pipeline::SampleHistory *history = tile.pipeline->getHistory();
+    if (history == nullptr) {
+        regionStatus = "no history kept";
+        return;
+    }
+
+    /* Rows shown in the selection */
+    unsigned int begin = std::min(selectionBegin, selectionEnd);
+    unsigned int end = std::max(selectionBegin, selectionEnd);
+    while (begin <= end && tile.centers[begin] == NoPosition)
+        begin++;
+    if (begin > end) {
+        regionStatus = "";
+        return;
+    }
+
+    /* Window centers of the first and last row, as they were computed */
+    uint64_t first = tile.centers[begin];
+    uint64_t last = std::max(tile.centers[end], first);
+
+    Settings analysisSettings = regionSettings;
+    analysisSettings.dftSize = regionDftSize;
+    analysisSettings.dftWf = regionWf;
+    analysisSettings.magnitudeMin = settings.magnitudeMin;
+    analysisSettings.magnitudeMax = settings.magnitudeMax;
+    analysisSettings.magnitudeLog = settings.magnitudeLog;
+    analysisSettings.colors = settings.colors;
+
+    regionAnalysis.reset(new RegionAnalysis(*history, tile.pipeline->getSampleRate(), first, last, end - begin + 1, analysisSettings));
+    regionBegin = begin;
+    regionStatus = (first < history->getBegin() + regionDftSize / 2) ? "analyzing, partly no longer kept" : "analyzing";
+}
+
+void InterfaceThread::showRegionAnalysis() {
+    Tile &tile = tiles[selectionTile];
+
+    for (unsigned int i = 0; i < regionAnalysis->getRows(); i++) {
+        const std::vector<uint32_t> &row = regionAnalysis->getRow(i);
+        if (!row.empty())
+            drawRow(tile, regionBegin + i, row.data());
+    }
+
+    SDL_UpdateTexture(tile.pixelsTexture, nullptr, tile.pixels.get(), static_cast<int>(width * sizeof(uint32_t)));
+
+    regionShown = true;
+    regionStatus = "done";
     renderSettings();
 }
 
+void InterfaceThread::renderNames() {
+    SDL_Color nameColor = {0xff, 0x00, 0x00, 0x00};
+
+    for (Tile &tile : tiles) {
+        SDL_Surface *nameSurface = renderString(tile.name.empty() ? std::string(" ") : tile.name, font, nameColor);
+
+        /* Top left corner of the tile */
+        tile.nameRect.x = tile.rect.x + 5;
+        tile.nameRect.y = tile.rect.y + 2;
+        tile.nameRect.w = nameSurface->w;
+        tile.nameRect.h = nameSurface->h;
+
+        if (tile.nameTexture)
+            SDL_DestroyTexture(tile.nameTexture);
+
+        tile.nameTexture = SDL_CreateTextureFromSurface(renderer, nameSurface);
+        if (tile.nameTexture == nullptr)
+            throw SDLException("Error creating texture for name text: SDL_CreateTextureFromSurface(): " + std::string(SDL_GetError()));
+
+        SDL_FreeSurface(nameSurface);
+    }
+}
+
 void InterfaceThread::run() {
-    std::unique_ptr<uint32_t[]> pixels = std::unique_ptr<uint32_t[]>(new uint32_t[width * height]);
-    std::vector<uint32_t> newPixels;
+    unsigned int rowsMax = (orientation == Orientation::Vertical) ? height : width;
+    std::vector<Buffer<uint32_t> *> newRows;
+
+    /* Reserve new rows for a full screen, so collecting rows never allocates */
+    newRows.reserve(rowsMax);
 
     auto statisticsTic = std::chrono::system_clock::now();
 
+    /* Latency mode: lock memory, now that the pipeline buffers are allocated */
+    if (latencyMode) {
+        effectiveMemoryLock = Realtime::lockMemory();
+        Realtime::prefaultStack();
+    }
+    effectiveThreadSettings = Realtime::configureThread(pthread_self(), threadSettings, "UI");
+
     running = true;
 
     /* Initialize pixels */
-    memset(pixels.get(), 0x00, width * height * sizeof(uint32_t));
+    for (Tile &tile : tiles)
+        memset(tile.pixels.get(), 0x00, width * height * sizeof(uint32_t));
 
     /* Poll current settings */
     updateSettings();
@@ -488,65 +780,153 @@ void InterfaceThread::run() {
                 int mx, my;
                 SDL_GetMouseState(&mx, &my);
                 renderCursor(mx, my);
+                if (selecting)
+                    selectionEnd = rowAt(tiles[selectionTile], mx, my);
+            } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT && frozen) {
+                /* Start selecting a region on the tile under the cursor */
+                renderCursor(e.button.x, e.button.y);
+                regionAnalysis.reset();
+                selecting = true;
+                selectionTile = selected;
+                selectionBegin = selectionEnd = rowAt(tiles[selectionTile], e.button.x, e.button.y);
+            } else if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && selecting) {
+                selecting = false;
+                startRegionAnalysis();
+                renderSettings();
+            }
+        }
+
+        /* A switch of sample rate that ended without the rate changing
+         * (e.g. the new stream failed) won't be followed by rows at it */
+        if (switchingSampleRate > 0) {
+            bool switching = false;
+            forEachPipeline([&](SpectrogramPipeline &pipeline) { switching = pipeline.isSwitchingAudioSampleRate() || switching; });
+            if (!switching && spectrogramPipeline().getAudioSampleRate() / decimation != switchingSampleRate) {
+                switchingSampleRate = 0;
+                renderSettings();
             }
         }
 
+        /* Show the region analyzed once finished */
+        if (regionAnalysis && !regionShown && regionAnalysis->isFinished())
+            showRegionAnalysis();
+
         /* Update statistics every 500ms */
         if (!hideStatistics && (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - statisticsTic).count() > 500)) {
             renderStatistics();
             statisticsTic = std::chrono::system_clock::now();
         }
 
-        /* Collect all new pixel rows */
-        while (!pixelsQueue.empty()) {
-            std::vector<uint32_t> pixelRow(pixelsQueue.pop());
-            newPixels.insert(newPixels.end(), pixelRow.begin(), pixelRow.end());
-        }
+        for (Tile &tile : tiles) {
+            BufferQueue<uint32_t> &pixelsQueue = *tile.pixelsQueue;
+            uint32_t *pixels = tile.pixels.get();
 
-        /* Update pixel buffer with new pixels */
-        if (newPixels.size() > 0) {
-            uint32_t *data = newPixels.data();
-            size_t size = newPixels.size();
+            /* Collect all new pixel rows */
+            size_t rowsCount = pixelsQueue.count();
 
-            if (size > width * height) {
-                /* Pixel buffer overrun (this should seldom happen). */
-                /* Use the last width*height pixels */
-                data = newPixels.data() + (width * height - size);
-                size = width * height;
+            /* Pixel buffer overrun (this should seldom happen). */
+            /* Skip to the last rowsMax rows */
+            for (; rowsCount > rowsMax; rowsCount--) {
+                Buffer<uint32_t> *pixelRow = pixelsQueue.pop();
+                if (pixelRow == nullptr)
+                    break;
+                pixelsQueue.release(pixelRow);
             }
 
-            if (orientation == Orientation::Vertical) {
-                /* Move old pixels up */
-                memmove(pixels.get(), pixels.get() + size, (width * height - size) * sizeof(uint32_t));
-
-                /* Copy new pixels over */
-                memcpy(pixels.get() + (width * height - size), data, size * sizeof(uint32_t));
-            } else {
-                unsigned int colsToShift = std::min(static_cast<unsigned int>(size / height), width);
-
-                /* Move old pixels to the left */
-                for (unsigned int x = 0; x < (width - colsToShift); x++)
-                    for (unsigned int y = 0; y < height; y++)
-                        pixels[y * width + x] = pixels[y * width + x + colsToShift];
-
-                /* Copy new pixels over */
-                unsigned int i = 0;
-                for (unsigned int x = width - colsToShift; x < width; x++)
-                    for (unsigned int y = 0; y < height; y++)
-                        pixels[(height - y) * width + x] = data[i++];
+            /* Pop rows first, the producer may take back queued rows under a drop policy */
+            newRows.clear();
+            for (; rowsCount > 0; rowsCount--) {
+                Buffer<uint32_t> *pixelRow = pixelsQueue.pop();
+                if (pixelRow == nullptr)
+                    break;
+                newRows.push_back(pixelRow);
             }
 
-            /* Clear new pixels */
-            newPixels.clear();
+            /* Frozen display: return pixel rows to the pool unseen */
+            if (frozen) {
+                for (Buffer<uint32_t> *pixelRow : newRows)
+                    pixelsQueue.release(pixelRow);
+                continue;
+            }
 
-            SDL_UpdateTexture(pixelsTexture, nullptr, pixels.get(), static_cast<int>(width * sizeof(uint32_t)));
+            /* Update pixel buffer with new pixel rows */
+            if (newRows.size() > 0) {
+                unsigned int rowsToShift = static_cast<unsigned int>(newRows.size());
+
+                if (orientation == Orientation::Vertical) {
+                    /* Move old pixels up */
+                    memmove(pixels, pixels + rowsToShift * width, (height - rowsToShift) * width * sizeof(uint32_t));
+
+                    /* Copy new pixel rows over */
+                    for (unsigned int i = 0; i < rowsToShift; i++)
+                        memcpy(pixels + (height - rowsToShift + i) * width, newRows[i]->data.data(), width * sizeof(uint32_t));
+                } else {
+                    /* Move old pixels to the left */
+                    for (unsigned int x = 0; x < (width - rowsToShift); x++)
+                        for (unsigned int y = 0; y < height; y++)
+                            pixels[y * width + x] = pixels[y * width + x + rowsToShift];
+
+                    /* Copy new pixel rows over as columns */
+                    for (unsigned int i = 0; i < rowsToShift; i++)
+                        for (unsigned int y = 0; y < height; y++)
+                            pixels[(height - 1 - y) * width + (width - rowsToShift + i)] = newRows[i]->data[y];
+                }
+
+                /* Track window centers of the rows shown, with the DFT size
+                 * each was computed with */
+                std::move(tile.centers.begin() + rowsToShift, tile.centers.end(), tile.centers.begin());
+                for (unsigned int i = 0; i < rowsToShift; i++)
+                    tile.centers[rowsMax - rowsToShift + i] = newRows[i]->position + newRows[i]->span / 2;
+
+                /* Follow a switch of sample rate with the rows at the new rate */
+                if (newRows.back()->sampleRate != tile.sampleRate) {
+                    tile.sampleRate = newRows.back()->sampleRate;
+                    if (&tile == &tiles[selected]) {
+                        settings.audioSampleRate = tile.sampleRate;
+                        switchingSampleRate = 0;
+                        renderSettings();
+                    }
+                }
+
+                /* Track latency from capture of the newest samples to display */
+                if (newRows.back()->timestamp != std::chrono::steady_clock::time_point())
+                    tile.displayLatency = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - newRows.back()->timestamp).count());
+
+                /* Return pixel rows to the pool */
+                for (Buffer<uint32_t> *pixelRow : newRows)
+                    pixelsQueue.release(pixelRow);
+
+                SDL_UpdateTexture(tile.pixelsTexture, nullptr, pixels, static_cast<int>(width * sizeof(uint32_t)));
+            }
         }
 
         SDL_RenderClear(renderer);
         /* Render pixels */
-        SDL_RenderCopy(renderer, pixelsTexture, nullptr, nullptr);
-        /* Render settings and cursor */
+        for (Tile &tile : tiles)
+            SDL_RenderCopy(renderer, tile.pixelsTexture, nullptr, &tile.rect);
+        /* Render region selected */
+        if (frozen && (selecting || regionAnalysis)) {
+            const Tile &tile = tiles[selectionTile];
+            int begin = static_cast<int>(std::min(selectionBegin, selectionEnd));
+            int end = static_cast<int>(std::max(selectionBegin, selectionEnd));
+            SDL_Rect selectionRect = tile.rect;
+            if (orientation == Orientation::Vertical) {
+                selectionRect.y += begin;
+                selectionRect.h = end - begin + 1;
+            } else {
+                selectionRect.x += begin;
+                selectionRect.w = end - begin + 1;
+            }
+            SDL_SetRenderDrawColor(renderer, 0xff, 0xff, 0xff, 0xff);
+            SDL_RenderDrawRect(renderer, &selectionRect);
+            SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xff);
+        }
+        /* Render names, settings and cursor */
         if (!hideInfo) {
+            for (Tile &tile : tiles) {
+                if (tile.nameTexture)
+                    SDL_RenderCopy(renderer, tile.nameTexture, nullptr, &tile.nameRect);
+            }
             SDL_RenderCopy(renderer, settingsTexture, nullptr, &settingsRect);
             SDL_RenderCopy(renderer, cursorTexture, nullptr, &cursorRect);
         }
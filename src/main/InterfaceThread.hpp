@@ -2,35 +2,65 @@
 #define _INTERFACETHREAD_HPP
 
 #include <functional>
+#include <vector>
+#include <string>
+#include <memory>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
-#include "ThreadSafeQueue.hpp"
-#include "AudioThread.hpp"
-#include "SpectrogramThread.hpp"
+#include "pipeline/BufferQueue.hpp"
+#include "pipeline/Realtime.hpp"
+#include "SpectrogramPipeline.hpp"
+#include "RegionAnalysis.hpp"
 #include "Configuration.hpp"
 
 class InterfaceThread {
   public:
-    InterfaceThread(ThreadSafeQueue<std::vector<uint32_t>> &pixelsQueue, AudioThread &audioThread, SpectrogramThread &spectrogramThread, const Configuration::Settings &initialSettings);
+    /* A pipeline per tile, laid out in a grid across the window, each tile
+     * labelled with its name when there are several. The width and height
+     * settings are of a tile. Controls apply to every pipeline, and
+     * statistics are of the tile under the cursor. */
+    InterfaceThread(const std::vector<SpectrogramPipeline *> &spectrogramPipelines, const std::vector<std::string> &names, const Configuration::Settings &initialSettings);
     ~InterfaceThread();
 
     void run();
 
+    /* Grid of columns by rows for a count of tiles, with more of them side
+     * by side across the frequency axis than along the time axis */
+    static void getTileGrid(size_t tiles, Configuration::Orientation orientation, unsigned int &columns, unsigned int &rows);
+
   private:
-    /* Pixels input queue */
-    ThreadSafeQueue<std::vector<uint32_t>> &pixelsQueue;
-    /* References to other threads for control */
-    AudioThread &audioThread;
-    SpectrogramThread &spectrogramThread;
+    /* Pipeline rendering into a tile of the window */
+    struct Tile {
+        SpectrogramPipeline *pipeline;
+        /* Pixels input queue */
+        BufferQueue<uint32_t> *pixelsQueue;
+        std::string name;
+        /* Tile pixels, the stream position of the window center of each row
+         * shown (NoPosition for none yet), and their texture and place in
+         * the window */
+        std::unique_ptr<uint32_t[]> pixels;
+        std::vector<uint64_t> centers;
+        SDL_Texture *pixelsTexture;
+        SDL_Rect rect;
+        SDL_Texture *nameTexture;
+        SDL_Rect nameRect;
+        /* Capture to display latency of the newest row shown, in milliseconds */
+        unsigned int displayLatency;
+        /* Sample rate of the newest row shown, which the frequency axis follows */
+        unsigned int sampleRate;
+    };
+
+    std::vector<Tile> tiles;
+    /* Tile under the cursor */
+    size_t selected;
     /* Running boolean */
     std::atomic<bool> running;
 
     /* Owned resources (SDL) */
     SDL_Window *win;
     SDL_Renderer *renderer;
-    SDL_Texture *pixelsTexture;
     SDL_Texture *settingsTexture;
     SDL_Texture *cursorTexture;
     SDL_Texture *statisticsTexture;
@@ -39,10 +69,45 @@ class InterfaceThread {
     SDL_Rect statisticsRect;
     TTF_Font *font;
 
-    /* Interface settings */
+    /* Interface settings, of a tile, and the grid of tiles */
     const unsigned int width, height;
+    unsigned int columns, rows;
     const Configuration::Orientation orientation;
+    /* Channels stacked side by side across the frequency axis */
+    const unsigned int channels;
+    /* Band analyzed, above bandStart Hz, with a decimation above 1 */
+    const double bandStart;
+    const unsigned int decimation;
     bool hideInfo, hideStatistics;
+    /* Audio sample rate switched to, until its rows are shown, 0 for none */
+    unsigned int switchingSampleRate;
+
+    /* Frozen display: rows keep being drained, but not shown. A region of
+     * rows selected on it is analyzed again with its own DFT settings, and
+     * shown in place of the rows. */
+    bool frozen;
+    bool selecting;
+    size_t selectionTile;
+    unsigned int selectionBegin, selectionEnd;
+    unsigned int regionDftSize;
+    DFT::RealDft::WindowFunction regionWf;
+    const Configuration::Settings regionSettings;
+    std::unique_ptr<RegionAnalysis> regionAnalysis;
+    unsigned int regionBegin;
+    bool regionShown;
+    std::string regionStatus;
+
+    /* Latency settings requested, and in effect */
+    const bool latencyMode;
+    const unsigned int audioReadSize, audioFragmentSize;
+    Realtime::ThreadSettings threadSettings;
+    std::string effectiveThreadSettings;
+    std::string effectiveMemoryLock;
+
+    /* Pipeline of the tile under the cursor, and every pipeline for control */
+    SpectrogramPipeline &spectrogramPipeline();
+    template <typename Function>
+    void forEachPipeline(Function function);
 
     /* Helper functions for SDL */
     void handleKeyDown(const uint8_t *state);
@@ -50,6 +115,15 @@ class InterfaceThread {
     void renderSettings();
     void renderCursor(int x, int y);
     void renderStatistics();
+    void renderNames();
+
+    /* Row of a tile the cursor is on, along the time axis */
+    unsigned int rowAt(const Tile &tile, int x, int y);
+    /* Draw a row into a tile's pixels, oldest at 0 */
+    void drawRow(Tile &tile, unsigned int index, const uint32_t *row);
+    /* Analyze the selected region again, with the region settings */
+    void startRegionAnalysis();
+    void showRegionAnalysis();
 
     /* Cached settings from audio source, dft, and spectrogram classes */
     struct {
@@ -62,6 +136,12 @@ class InterfaceThread {
         bool magnitudeLog;
         Spectrogram::SpectrumRenderer::ColorScheme colors;
     } settings;
+
+    /* Previously rendered debug statistics, for steady-state deltas */
+    struct {
+        size_t audioAllocations;
+        size_t spectrogramAllocations;
+    } lastStatistics;
 };
 
 class SDLException : public std::runtime_error {
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+
+#include "RegionAnalysis.hpp"
+
+RegionAnalysis::RowsSink::RowsSink() : finished(false) {}
+
+void RegionAnalysis::RowsSink::append(const std::vector<uint32_t> &pixels) {
+    rows.push_back(pixels);
+}
+
+void RegionAnalysis::RowsSink::write() {
+    finished.store(true, std::memory_order_release);
+}
+
+RegionAnalysis::RegionAnalysis(Pipeline::SampleHistory &history, unsigned int sampleRate, uint64_t first, uint64_t last, unsigned int rows, const Configuration::Settings &settings) : rows(rows), first(first) {
+    unsigned int N = settings.dftSize;
+
+    /* A frame per row, unless rows are further apart than a DFT */
+    rowSpacing = (rows > 1) ? static_cast<double>(last - first) / static_cast<double>(rows - 1) : 0.0;
+    unsigned int rowHop = std::min<unsigned int>(std::max(static_cast<unsigned int>(std::lround(rowSpacing)), 1u), N);
+
+    /* An offline render of the region: blocking links, no shedding, no
+     * realtime scheduling, and no band selection, the history is of the
+     * analyzed samples */
+    Configuration::Settings regionSettings = settings;
+    regionSettings.samplesOverlap = static_cast<float>(N - rowHop) / static_cast<float>(N);
+    regionSettings.audioReadSize = settings.fileReadSize;
+    regionSettings.decimation = 1;
+    regionSettings.bandStart = 0.0;
+    regionSettings.start = regionSettings.duration = 0.0;
+    regionSettings.startSample = 0;
+    regionSettings.historySeconds = 0.0;
+    regionSettings.channelLayout = Configuration::ChannelLayout::Stacked;
+    regionSettings.executor = Configuration::Executor::Auto;
+    regionSettings.latencyMode = false;
+    regionSettings.audioCpu = regionSettings.dftCpu = -1;
+
+    /* Hop as the window stage takes it from the overlap */
+    hop = N - static_cast<unsigned int>(regionSettings.samplesOverlap * static_cast<float>(N));
+
+    /* Half a window either side of the centers, clamped at the start of the stream */
+    uint64_t begin = (first > N / 2) ? first - N / 2 : 0;
+    uint64_t end = std::max<uint64_t>(last + N / 2, begin + N);
+    /* The window stage emits a frame every hop, from the first hop in */
+    frameCenter = static_cast<double>(begin + hop) - static_cast<double>(N / 2);
+
+    sink.rows.reserve(static_cast<size_t>((end - begin) / hop + 2));
+
+    audioSource.reset(new Audio::HistoryAudioSource(history, sampleRate, begin, end - begin));
+    pipeline.reset(new SpectrogramPipeline(*audioSource, {&sink}, regionSettings));
+    pipeline->start();
+}
+
+RegionAnalysis::~RegionAnalysis() {
+    pipeline->stop();
+}
+
+bool RegionAnalysis::isFinished() {
+    return sink.finished.load(std::memory_order_acquire);
+}
+
+unsigned int RegionAnalysis::getRows() {
+    return rows;
+}
+
+const std::vector<uint32_t> &RegionAnalysis::getRow(unsigned int row) {
+    static const std::vector<uint32_t> none;
+
+    if (!isFinished() || sink.rows.empty())
+        return none;
+
+    /* Frame centered nearest the row's center */
+    double offset = static_cast<double>(first) + static_cast<double>(row) * rowSpacing - frameCenter;
+    size_t frame = static_cast<size_t>(std::max(std::lround(offset / static_cast<double>(hop)), 0l));
+
+    return sink.rows[std::min(frame, sink.rows.size() - 1)];
+}
@@ -0,0 +1,60 @@
+#ifndef _REGIONANALYSIS_HPP
+#define _REGIONANALYSIS_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "audio/HistoryAudioSource.hpp"
+#include "image/ImageSink.hpp"
+#include "pipeline/SampleHistory.hpp"
+#include "SpectrogramPipeline.hpp"
+#include "Configuration.hpp"
+
+/* Analyzes a region of a pipeline's sample history again in the background,
+ * with other DFT settings, into as many rows as the region spans on the
+ * display. The region runs from the center of its first row's window to the
+ * center of its last, and the frames analyzed are centered on the rows, so
+ * the result lines up with the rows it replaces. The history keeps being
+ * written meanwhile, capture carries on. */
+class RegionAnalysis {
+  public:
+    /* Window centers of the first and last row in stream positions, and the
+     * settings analyzed with, of which the width of a row is kept */
+    RegionAnalysis(Pipeline::SampleHistory &history, unsigned int sampleRate, uint64_t first, uint64_t last, unsigned int rows, const Configuration::Settings &settings);
+    ~RegionAnalysis();
+
+    bool isFinished();
+
+    /* Rows of the region, once finished, an empty row if there is none */
+    unsigned int getRows();
+    const std::vector<uint32_t> &getRow(unsigned int row);
+
+  private:
+    /* Collects the rows analyzed, and notes the end of the region */
+    class RowsSink : public Image::ImageSink {
+      public:
+        RowsSink();
+        virtual void append(const std::vector<uint32_t> &pixels);
+        virtual void write();
+
+        std::vector<std::vector<uint32_t>> rows;
+        std::atomic<bool> finished;
+    };
+
+    const unsigned int rows;
+    /* Center of the first row, distance between rows, center of the first
+     * frame (before the start of the region, its window is not yet full),
+     * and hop between frames, in frames */
+    const uint64_t first;
+    double rowSpacing;
+    double frameCenter;
+    unsigned int hop;
+
+    std::unique_ptr<Audio::HistoryAudioSource> audioSource;
+    RowsSink sink;
+    std::unique_ptr<SpectrogramPipeline> pipeline;
+};
+
+#endif
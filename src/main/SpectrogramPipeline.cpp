@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <thread>
+
+#include "SpectrogramPipeline.hpp"
+
+using namespace Pipeline;
+
+static unsigned int pixelsWidth(const Configuration::Settings &settings) {
+    return (settings.orientation == Configuration::Orientation::Vertical) ? settings.width : settings.height;
+}
+
+/* Scheduling and affinity of the audio and DFT stages */
+static Realtime::ThreadSettings audioThreadSettings(const Configuration::Settings &settings) {
+    Realtime::ThreadSettings threadSettings;
+    threadSettings.cpu = settings.audioCpu;
+    threadSettings.scheduler = settings.latencyMode ? settings.latencyScheduler : Realtime::Scheduler::Other;
+    threadSettings.priority = settings.audioPriority;
+    return threadSettings;
+}
+
+static Realtime::ThreadSettings dftThreadSettings(const Configuration::Settings &settings) {
+    Realtime::ThreadSettings threadSettings;
+    threadSettings.cpu = settings.dftCpu;
+    threadSettings.scheduler = settings.latencyMode ? settings.latencyScheduler : Realtime::Scheduler::Other;
+    threadSettings.priority = settings.dftPriority;
+    return threadSettings;
+}
+
+static size_t poolThreads(const Configuration::Settings &settings) {
+    return (settings.executorThreads > 0) ? settings.executorThreads : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+static FrameSettings initialFrameSettings(const Configuration::Settings &settings) {
+    return {settings.dftSize, settings.dftWf, static_cast<unsigned int>(settings.samplesOverlap * static_cast<float>(settings.dftSize)), {settings.magnitudeMin, settings.magnitudeMax, settings.magnitudeLog, settings.colors}, 1};
+}
+
+/* A file is rendered in full, so its links block rather than drop, and no work is shed */
+SpectrogramPipeline::SpectrogramPipeline(Audio::AudioSource &audioSource, const std::vector<Image::ImageSink *> &imageSinks, const Configuration::Settings &initialSettings, Executor *sharedExecutor) : audioSource(audioSource), mixer(audioSource.getChannels(), initialSettings.channelMode, initialSettings.channel), samplesQueue(std::max<size_t>(initialSettings.samplesQueueCapacity / (initialSettings.audioReadSize * audioSource.getChannels()), 2), initialSettings.audioReadSize * audioSource.getChannels(), imageSinks.empty() ? initialSettings.samplesQueuePolicy : QueuePolicy::Block), pixelsQueue(initialSettings.pixelsQueueCapacity, pixelsWidth(initialSettings), imageSinks.empty() ? initialSettings.pixelsQueuePolicy : QueuePolicy::Block), settings(initialFrameSettings(initialSettings)), loadController({initialSettings.loadShedding && imageSinks.empty(), initialSettings.loadSheddingOverlapMin, initialSettings.loadSheddingSkipMax, initialSettings.loadSheddingPixelStepMax}), executor(sharedExecutor), bandStart(initialSettings.bandStart), decimation(std::max(initialSettings.decimation, 1u)) {
+    unsigned int channels = mixer.getOutputChannels();
+    bool stacked = channels > 1 && initialSettings.channelLayout == Configuration::ChannelLayout::Stacked;
+    /* A multiple of the channels, so every transform sees frames of one channel only */
+    unsigned int transforms = std::max(initialSettings.dftThreads, 1u);
+    transforms = ((transforms + channels - 1) / channels) * channels;
+    size_t frameSize = std::max(Configuration::UserLimits.dftSizeMax, initialSettings.dftSize);
+    size_t width = pixelsWidth(initialSettings);
+    /* Stacked channels share the width of a row */
+    size_t rowWidth = stacked ? width / channels : width;
+
+    /* Range of the source, primed with the overlap before its start so its
+     * first frame is a full window (in window stage frames, decimated) */
+    uint64_t start = (initialSettings.startSample > 0) ? initialSettings.startSample : static_cast<uint64_t>(initialSettings.start * audioSource.getSampleRate());
+    uint64_t length = (initialSettings.durationSamples > 0) ? initialSettings.durationSamples : static_cast<uint64_t>(initialSettings.duration * audioSource.getSampleRate());
+    size_t prime = static_cast<size_t>(std::min<uint64_t>(settings.get().samplesOverlap, start / decimation));
+    start -= prime * decimation;
+    if (length > 0)
+        length += prime * decimation;
+
+    /* The decimator's output lags its input by its group delay, and starts
+     * from a zeroed history: the source is read from up to the group delay
+     * earlier (on the decimated grid), so the filter is full at the start,
+     * and on by the group delay past the end, and the decimated lead in is
+     * dropped ahead of the window */
+    size_t leadFrames = 0;
+    if (decimation > 1) {
+        uint64_t delay = (DFT::BandDecimator::getTaps(decimation) - 1) / 2;
+        uint64_t lead = std::min<uint64_t>(start / decimation * decimation, delay);
+        start -= lead;
+        if (length > 0)
+            length += lead + delay;
+        leadFrames = static_cast<size_t>((lead + delay) / decimation);
+    }
+
+    /* Source and window */
+    sourceStage.reset(new SourceStage(audioSource, samplesQueue, initialSettings.audioReadSize, start, length));
+
+    /* Band selection, ahead of the window */
+    BufferQueue<double> *windowInput = &samplesQueue;
+    if (decimation > 1) {
+        decimatedQueue.reset(new BufferQueue<double>(samplesQueue.capacity(), (initialSettings.audioReadSize / decimation + 1) * audioSource.getChannels(), QueuePolicy::Block));
+        decimateStage.reset(new DecimateStage(samplesQueue, *decimatedQueue, audioSource.getChannels(), audioSource.getSampleRate(), bandStart, decimation, leadFrames));
+        windowInput = decimatedQueue.get();
+    }
+
+    /* Realtime input is kept for a region of a frozen display to be analyzed again */
+    if (imageSinks.empty() && initialSettings.historySeconds > 0)
+        history.reset(new SampleHistory(static_cast<size_t>(initialSettings.historySeconds * audioSource.getSampleRate() / decimation), audioSource.getChannels()));
+
+    /* Rows of stacked channels are collected before the pixels queue */
+    BufferQueue<uint32_t> *rowsOutput = &pixelsQueue;
+    if (stacked) {
+        channelRowsQueue.reset(new BufferQueue<uint32_t>(initialSettings.dftQueueDepth * channels, rowWidth, QueuePolicy::Block));
+        rowsOutput = channelRowsQueue.get();
+    }
+
+    /* A lone transform renders straight into the rows output, run by the
+     * window stage from the window in place. Replicas are fed copies of the
+     * windows over frame links, and their rows gathered back in order. */
+    std::vector<FrameLink *> frameOutputs;
+    if (transforms == 1) {
+        transformStages.emplace_back(new TransformStage(nullptr, *rowsOutput, settings.get(), rowWidth));
+    } else {
+        std::vector<BufferQueue<uint32_t> *> rowsInputs;
+        for (unsigned int i = 0; i < transforms; i++) {
+            frameLinks.emplace_back(new FrameLink(initialSettings.dftQueueDepth, frameSize));
+            frameOutputs.push_back(frameLinks.back().get());
+            rowsQueues.emplace_back(new BufferQueue<uint32_t>(initialSettings.dftQueueDepth, rowWidth));
+            rowsInputs.push_back(rowsQueues.back().get());
+            transformStages.emplace_back(new TransformStage(frameLinks[i].get(), *rowsQueues[i], settings.get(), rowWidth));
+        }
+        gatherStage.reset(new GatherStage(rowsInputs, *rowsOutput));
+    }
+
+    windowStage.reset(new WindowStage(*windowInput, frameOutputs, (transforms == 1) ? transformStages[0].get() : nullptr, mixer, settings, loadController, [this]() {
+        double frameSeconds = 0;
+        for (auto &transformStage : this->transformStages)
+            frameSeconds += transformStage->getFrameSeconds();
+        return frameSeconds / static_cast<double>(this->transformStages.size());
+    }, prime, history.get()));
+
+    if (stacked)
+        stackStage.reset(new StackStage(*channelRowsQueue, pixelsQueue, channels, width));
+
+    /* Sink */
+    if (!imageSinks.empty())
+        imageSinkStage.reset(new ImageSinkStage(pixelsQueue, imageSinks));
+
+    /* Transform replicas share the scheduling, but run on any cpu */
+    Realtime::ThreadSettings transformThreadSettings = dftThreadSettings(initialSettings);
+    if (transforms > 1)
+        transformThreadSettings.cpu = -1;
+
+    /* Executor */
+    Configuration::Executor executorType = initialSettings.executor;
+    if (executorType == Configuration::Executor::Auto)
+        executorType = (!imageSinks.empty() && transforms == 1) ? Configuration::Executor::Single : Configuration::Executor::ThreadPerStage;
+
+    if (sharedExecutor) {
+        executorName = "pooled, shared";
+    } else if (executorType == Configuration::Executor::Single) {
+        ownedExecutor.reset(new SingleThreadExecutor(dftThreadSettings(initialSettings), initialSettings.latencyMode));
+        executorName = "single thread";
+    } else if (executorType == Configuration::Executor::Pooled) {
+        ownedExecutor.reset(new PooledExecutor(poolThreads(initialSettings), dftThreadSettings(initialSettings), initialSettings.latencyMode));
+        executorName = "pooled";
+    } else {
+        ownedExecutor.reset(new ThreadPerStageExecutor(initialSettings.latencyMode));
+        executorName = "thread per stage";
+    }
+    if (ownedExecutor)
+        executor = ownedExecutor.get();
+
+    /* Files are read ahead on a thread of their own, off the DFT's critical
+     * path, and sources sharing an executor read on threads of their own */
+    executor->add(*sourceStage, audioThreadSettings(initialSettings), !imageSinks.empty() || sharedExecutor != nullptr);
+    if (decimateStage)
+        executor->add(*decimateStage, dftThreadSettings(initialSettings));
+    executor->add(*windowStage, dftThreadSettings(initialSettings));
+    if (transforms > 1) {
+        for (auto &transformStage : transformStages)
+            executor->add(*transformStage, transformThreadSettings);
+    }
+    if (gatherStage)
+        executor->add(*gatherStage, dftThreadSettings(initialSettings));
+    if (stackStage)
+        executor->add(*stackStage, dftThreadSettings(initialSettings));
+    if (imageSinkStage)
+        executor->add(*imageSinkStage, Realtime::ThreadSettings());
+}
+
+std::unique_ptr<Executor> SpectrogramPipeline::makeSharedExecutor(const Configuration::Settings &initialSettings) {
+    return std::unique_ptr<Executor>(new PooledExecutor(poolThreads(initialSettings), dftThreadSettings(initialSettings), initialSettings.latencyMode));
+}
+
+SpectrogramPipeline::~SpectrogramPipeline() {
+    stop();
+}
+
+void SpectrogramPipeline::start() {
+    if (ownedExecutor)
+        ownedExecutor->start();
+}
+
+void SpectrogramPipeline::join() {
+    if (ownedExecutor)
+        ownedExecutor->join();
+}
+
+void SpectrogramPipeline::stop() {
+    if (ownedExecutor)
+        ownedExecutor->stop();
+}
+
+BufferQueue<uint32_t> &SpectrogramPipeline::getPixelsQueue() {
+    return pixelsQueue;
+}
+
+unsigned int SpectrogramPipeline::getSampleRate() {
+    return decimateStage ? decimateStage->getSampleRate() : sourceStage->getSampleRate();
+}
+
+unsigned int SpectrogramPipeline::getAudioSampleRate() {
+    return sourceStage->getSampleRate();
+}
+
+bool SpectrogramPipeline::setAudioSampleRate(unsigned int sampleRate) {
+    if (decimateStage && bandStart + static_cast<double>(sampleRate) / (2.0 * decimation) > static_cast<double>(sampleRate) / 2.0)
+        return false;
+
+    return audioSource.setSampleRate(sampleRate);
+}
+
+bool SpectrogramPipeline::isSwitchingAudioSampleRate() {
+    return audioSource.isSwitchingSampleRate();
+}
+
+double SpectrogramPipeline::getBandStart() {
+    return bandStart;
+}
+
+unsigned int SpectrogramPipeline::getDecimation() {
+    return decimation;
+}
+
+unsigned int SpectrogramPipeline::getChannels() {
+    return mixer.getOutputChannels();
+}
+
+SampleHistory *SpectrogramPipeline::getHistory() {
+    return history.get();
+}
+
+float SpectrogramPipeline::getSamplesOverlap() {
+    Settings current = settings.get();
+    return static_cast<float>(current.samplesOverlap) / static_cast<float>(current.dftSize);
+}
+
+void SpectrogramPipeline::setSamplesOverlap(float overlap) {
+    settings.update([overlap](Settings &s) { s.samplesOverlap = static_cast<unsigned int>(overlap * static_cast<float>(s.dftSize)); });
+}
+
+unsigned int SpectrogramPipeline::getDftSize() {
+    return settings.get().dftSize;
+}
+
+void SpectrogramPipeline::setDftSize(unsigned int N) {
+    settings.update([N](Settings &s) {
+        /* Preserve overlap percentage */
+        float overlap = static_cast<float>(s.samplesOverlap) / static_cast<float>(s.dftSize);
+        s.dftSize = N;
+        s.samplesOverlap = static_cast<unsigned int>(overlap * static_cast<float>(N));
+    });
+}
+
+DFT::RealDft::WindowFunction SpectrogramPipeline::getDftWindowFunction() {
+    return settings.get().dftWf;
+}
+
+void SpectrogramPipeline::setDftWindowFunction(DFT::RealDft::WindowFunction wf) {
+    settings.update([wf](Settings &s) { s.dftWf = wf; });
+}
+
+double SpectrogramPipeline::getMagnitudeMin() {
+    return settings.get().spectrum.magnitudeMin;
+}
+
+void SpectrogramPipeline::setMagnitudeMin(double min) {
+    settings.update([min](Settings &s) { s.spectrum.magnitudeMin = min; });
+}
+
+double SpectrogramPipeline::getMagnitudeMax() {
+    return settings.get().spectrum.magnitudeMax;
+}
+
+void SpectrogramPipeline::setMagnitudeMax(double max) {
+    settings.update([max](Settings &s) { s.spectrum.magnitudeMax = max; });
+}
+
+bool SpectrogramPipeline::getMagnitudeLog() {
+    return settings.get().spectrum.magnitudeLog;
+}
+
+void SpectrogramPipeline::setMagnitudeLog(bool logarithmic) {
+    settings.update([logarithmic](Settings &s) { s.spectrum.magnitudeLog = logarithmic; });
+}
+
+Spectrogram::SpectrumRenderer::ColorScheme SpectrogramPipeline::getColors() {
+    return settings.get().spectrum.colors;
+}
+
+void SpectrogramPipeline::setColors(Spectrogram::SpectrumRenderer::ColorScheme colors) {
+    settings.update([colors](Settings &s) { s.spectrum.colors = colors; });
+}
+
+size_t SpectrogramPipeline::getDebugAudioOverflows() {
+    return audioSource.getDebugOverflows();
+}
+
+size_t SpectrogramPipeline::getDebugAudioUnderflows() {
+    return audioSource.getDebugUnderflows();
+}
+
+size_t SpectrogramPipeline::getDebugAudioSamplesLost() {
+    return audioSource.getDebugSamplesLost();
+}
+
+unsigned int SpectrogramPipeline::getDebugAudioLatency() {
+    return audioSource.getDebugLatency();
+}
+
+size_t SpectrogramPipeline::getDebugSamplesQueueCount() {
+    return samplesQueue.count() + (decimatedQueue ? decimatedQueue->count() : 0);
+}
+
+size_t SpectrogramPipeline::getDebugSamplesDropped() {
+    return samplesQueue.getDroppedElements();
+}
+
+size_t SpectrogramPipeline::getDebugSamplesQueueCapacity() {
+    return samplesQueue.capacity();
+}
+
+unsigned int SpectrogramPipeline::getDebugSamplesProducerWait() {
+    return static_cast<unsigned int>(samplesQueue.getProducerWait() / 1000);
+}
+
+unsigned int SpectrogramPipeline::getDebugSamplesConsumerWait() {
+    return static_cast<unsigned int>(samplesQueue.getConsumerWait() / 1000);
+}
+
+size_t SpectrogramPipeline::getDebugFramesQueued() {
+    size_t count = 0;
+    for (auto &frameLink : frameLinks)
+        count += frameLink->count();
+    for (auto &rowsQueue : rowsQueues)
+        count += rowsQueue->count();
+    if (channelRowsQueue)
+        count += channelRowsQueue->count();
+    return count;
+}
+
+size_t SpectrogramPipeline::getDebugDftThreads() {
+    return transformStages.size();
+}
+
+std::string SpectrogramPipeline::getDebugExecutor() {
+    return executorName;
+}
+
+std::string SpectrogramPipeline::getDebugAudioThreadSettings() {
+    return executor->getThreadSettings(*sourceStage);
+}
+
+std::string SpectrogramPipeline::getDebugDftThreadSettings() {
+    return executor->getThreadSettings(*windowStage);
+}
+
+unsigned int SpectrogramPipeline::getDebugLoadLevel() {
+    return loadController.getLevel();
+}
+
+unsigned int SpectrogramPipeline::getDebugLoadLevels() {
+    return loadController.getLevels();
+}
+
+unsigned int SpectrogramPipeline::getDebugLoadUtilization() {
+    return loadController.getUtilization();
+}
+
+unsigned int SpectrogramPipeline::getDebugLoadBacklog() {
+    return loadController.getBacklogMilliseconds();
+}
+
+LoadController::Degradation SpectrogramPipeline::getDebugLoadDegradation() {
+    return loadController.getDegradation();
+}
+
+size_t SpectrogramPipeline::getDebugAudioAllocations() {
+    return sourceStage->getAllocations();
+}
+
+size_t SpectrogramPipeline::getDebugDftAllocations() {
+    size_t allocations = windowStage->getAllocations();
+    if (decimateStage)
+        allocations += decimateStage->getAllocations();
+    for (auto &transformStage : transformStages)
+        allocations += transformStage->getAllocations();
+    if (gatherStage)
+        allocations += gatherStage->getAllocations();
+    if (stackStage)
+        allocations += stackStage->getAllocations();
+    return allocations;
+}
+
+uint64_t SpectrogramPipeline::getDebugSettingsVersion() {
+    return settings.getVersion();
+}
+
+size_t SpectrogramPipeline::getDebugSettingsContention() {
+    return settings.getWriterContention();
+}
@@ -0,0 +1,181 @@
+#ifndef _SPECTROGRAMPIPELINE_HPP
+#define _SPECTROGRAMPIPELINE_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+
+#include "audio/AudioSource.hpp"
+#include "audio/ChannelMixer.hpp"
+#include "image/ImageSink.hpp"
+#include "dft/RealDft.hpp"
+#include "spectrogram/SpectrumRenderer.hpp"
+#include "pipeline/CacheAligned.hpp"
+#include "pipeline/BufferQueue.hpp"
+#include "pipeline/Snapshot.hpp"
+#include "pipeline/LoadController.hpp"
+#include "pipeline/SampleHistory.hpp"
+#include "pipeline/FrameLink.hpp"
+#include "pipeline/SourceStage.hpp"
+#include "pipeline/DecimateStage.hpp"
+#include "pipeline/WindowStage.hpp"
+#include "pipeline/TransformStage.hpp"
+#include "pipeline/GatherStage.hpp"
+#include "pipeline/StackStage.hpp"
+#include "pipeline/ImageSinkStage.hpp"
+#include "pipeline/Executor.hpp"
+#include "Configuration.hpp"
+
+/* Spectrogram stage graph, shared by realtime and file modes:
+ *
+ *  source -> samples [-> decimate -> samples] -> window -> frames -> transform(s) [-> rows -> gather] [-> rows -> stack] -> pixels [-> image sink(s)]
+ *
+ * The window stage emits a frame per analysis channel, and the channels of
+ * a frame are stacked side by side into one row, or kept as rows of their own
+ * for an image sink per channel. With a decimation, a band of the audio is
+ * selected and analyzed at the decimated sample rate. In realtime mode the pixels queue is drained
+ * by the interface, and the samples analyzed can be kept in a history. In
+ * file mode it is drained by the image sink stage, and the source reads ahead
+ * on a thread of its own, whatever the executor. */
+class SpectrogramPipeline : public CacheAligned<SpectrogramPipeline> {
+  public:
+    /* Without image sinks, pixels are left in the pixels queue. With the
+     * separate channel layout, there is one image sink per channel. With a
+     * shared executor, the stages are added to it rather than to an executor
+     * of the pipeline's own, and its owner starts, joins and stops it. */
+    SpectrogramPipeline(Audio::AudioSource &audioSource, const std::vector<Image::ImageSink *> &imageSinks, const Configuration::Settings &initialSettings, Pipeline::Executor *sharedExecutor = nullptr);
+    ~SpectrogramPipeline();
+
+    /* Pooled executor for the pipelines of several sources to share, so their
+     * chains are stepped by one pool of threads. Sources read on threads of
+     * their own, so one blocked on its device never holds up the others. The
+     * executor must be stopped before its pipelines are destroyed. */
+    static std::unique_ptr<Pipeline::Executor> makeSharedExecutor(const Configuration::Settings &initialSettings);
+
+    /* Start, join and stop the pipeline's own executor, no-ops with a shared one */
+    void start();
+    /* Block until the end of the audio source has passed through */
+    void join();
+    void stop();
+
+    /* Output pixels queue, when there is no image sink */
+    BufferQueue<uint32_t> &getPixelsQueue();
+
+    /* Get analyzed sample rate in Hz, decimated from the AudioSource's */
+    unsigned int getSampleRate();
+
+    /* Get AudioSource sample rate in Hz, and switch it while running, rows
+     * at the new rate following the old ones. Returns false if the source
+     * can't switch, or the band analyzed doesn't fit the new rate. A switch
+     * can still fail later, when it ends without the rate changing. */
+    unsigned int getAudioSampleRate();
+    bool setAudioSampleRate(unsigned int sampleRate);
+    bool isSwitchingAudioSampleRate();
+
+    /* Get start of the analyzed band in Hz, and decimation factor */
+    double getBandStart();
+    unsigned int getDecimation();
+
+    /* Get number of analysis channels */
+    unsigned int getChannels();
+
+    /* Get history of the samples analyzed, at the analyzed sample rate, or
+     * nullptr if none is kept */
+    Pipeline::SampleHistory *getHistory();
+
+    /* Get/Set Samples Overlap (0.00 - 1.00) */
+    float getSamplesOverlap();
+    void setSamplesOverlap(float overlap);
+
+    /* Get/Set DFT Size (power of two) */
+    unsigned int getDftSize();
+    void setDftSize(unsigned int N);
+
+    /* Get/Set DFT Window Function */
+    DFT::RealDft::WindowFunction getDftWindowFunction();
+    void setDftWindowFunction(DFT::RealDft::WindowFunction wf);
+
+    /* Get/Set Spectrogram Magnitude Minimum */
+    double getMagnitudeMin();
+    void setMagnitudeMin(double min);
+
+    /* Get/Set Spectrogram Magnitude Maximum */
+    double getMagnitudeMax();
+    void setMagnitudeMax(double max);
+
+    /* Get/Set Spectrogram Magnitude Logarithmic/Linear */
+    bool getMagnitudeLog();
+    void setMagnitudeLog(bool logarithmic);
+
+    /* Get/Set Spectrogram Color Scheme */
+    Spectrogram::SpectrumRenderer::ColorScheme getColors();
+    void setColors(Spectrogram::SpectrumRenderer::ColorScheme colors);
+
+    /* Debug Statistics */
+    size_t getDebugAudioOverflows();
+    size_t getDebugAudioUnderflows();
+    size_t getDebugAudioSamplesLost();
+    unsigned int getDebugAudioLatency();
+    size_t getDebugSamplesQueueCount();
+    size_t getDebugSamplesDropped();
+    size_t getDebugSamplesQueueCapacity();
+    /* Time the source waited on a full samples queue, and its consumer on an empty one, in milliseconds */
+    unsigned int getDebugSamplesProducerWait();
+    unsigned int getDebugSamplesConsumerWait();
+    size_t getDebugFramesQueued();
+    size_t getDebugDftThreads();
+    std::string getDebugExecutor();
+    std::string getDebugAudioThreadSettings();
+    std::string getDebugDftThreadSettings();
+    unsigned int getDebugLoadLevel();
+    unsigned int getDebugLoadLevels();
+    unsigned int getDebugLoadUtilization();
+    unsigned int getDebugLoadBacklog();
+    LoadController::Degradation getDebugLoadDegradation();
+    size_t getDebugAudioAllocations();
+    size_t getDebugDftAllocations();
+    uint64_t getDebugSettingsVersion();
+    size_t getDebugSettingsContention();
+
+  private:
+    typedef Pipeline::FrameSettings Settings;
+
+    Audio::AudioSource &audioSource;
+    /* Input channels to analysis channels */
+    Audio::ChannelMixer mixer;
+
+    /* Links */
+    BufferQueue<double> samplesQueue;
+    std::unique_ptr<BufferQueue<double>> decimatedQueue;
+    std::vector<std::unique_ptr<Pipeline::FrameLink>> frameLinks;
+    std::vector<std::unique_ptr<BufferQueue<uint32_t>>> rowsQueues;
+    std::unique_ptr<BufferQueue<uint32_t>> channelRowsQueue;
+    BufferQueue<uint32_t> pixelsQueue;
+
+    /* Settings published by the interface, picked up once per hop */
+    Snapshot<Settings> settings;
+
+    /* Sheds work when the pipeline falls behind */
+    LoadController loadController;
+
+    /* Samples analyzed, kept for a region to be analyzed again */
+    std::unique_ptr<Pipeline::SampleHistory> history;
+
+    /* Stages */
+    std::unique_ptr<Pipeline::SourceStage> sourceStage;
+    std::unique_ptr<Pipeline::DecimateStage> decimateStage;
+    std::unique_ptr<Pipeline::WindowStage> windowStage;
+    std::vector<std::unique_ptr<Pipeline::TransformStage>> transformStages;
+    std::unique_ptr<Pipeline::GatherStage> gatherStage;
+    std::unique_ptr<Pipeline::StackStage> stackStage;
+    std::unique_ptr<Pipeline::ImageSinkStage> imageSinkStage;
+
+    std::unique_ptr<Pipeline::Executor> ownedExecutor;
+    Pipeline::Executor *executor;
+    std::string executorName;
+
+    const double bandStart;
+    const unsigned int decimation;
+};
+
+#endif
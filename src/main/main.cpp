@@ -1,18 +1,26 @@
-#include <thread>
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <functional>
 #include <getopt.h>
+#include <sys/stat.h>
 
 #include "audio/PulseAudioSource.hpp"
-#include "dft/RealDft.hpp"
-#include "spectrogram/SpectrumRenderer.hpp"
-
 #include "audio/WaveAudioSource.hpp"
+#include "audio/MappedWaveAudioSource.hpp"
+#include "audio/StreamAudioSource.hpp"
+#include "audio/UdpAudioSource.hpp"
+#include "audio/PacedAudioSource.hpp"
+#include "audio/GeneratorAudioSource.hpp"
 #include "image/MagickImageSink.hpp"
+#include "image/RawImageSink.hpp"
+#include "image/PngImageSink.hpp"
+#include "image/BufferImageSink.hpp"
 
-#include "ThreadSafeQueue.hpp"
-
-#include "AudioThread.hpp"
-#include "SpectrogramThread.hpp"
+#include "SpectrogramPipeline.hpp"
 #include "InterfaceThread.hpp"
 #include "Configuration.hpp"
 
@@ -28,72 +36,269 @@ Limits UserLimits;
 
 using namespace Configuration;
 
+/* Streams are stdin ("-"), FIFOs and character devices, or anything with an input format set */
+bool is_stream(std::string audioPath) {
+    struct stat st;
+    if (audioPath == "-" || InitialSettings.inputFormat != InputFormat::Auto)
+        return true;
+    return stat(audioPath.c_str(), &st) == 0 && (S_ISFIFO(st.st_mode) || S_ISCHR(st.st_mode));
+}
+
+/* Raw images are written to stdout ("-") or to files with a .raw extension */
+bool is_raw_image(std::string imagePath) {
+    return imagePath == "-" || (imagePath.size() > 4 && imagePath.compare(imagePath.size() - 4, 4, ".raw") == 0);
+}
+
+/* PNG images are streamed to the file as rows are rendered */
+bool is_png_image(std::string imagePath) {
+    return imagePath.size() > 4 && imagePath.compare(imagePath.size() - 4, 4, ".png") == 0;
+}
+
+/* Uncompressed WAV files are read straight from a mapping, anything else
+ * through libsndfile, and streams as they arrive */
+std::unique_ptr<AudioSource> open_audiofile(std::string audioPath) {
+    if (is_stream(audioPath)) {
+        StreamAudioSource::Format format = StreamAudioSource::Format::Wav;
+        if (InitialSettings.inputFormat == InputFormat::S16)
+            format = StreamAudioSource::Format::S16;
+        else if (InitialSettings.inputFormat == InputFormat::S32)
+            format = StreamAudioSource::Format::S32;
+        else if (InitialSettings.inputFormat == InputFormat::F32)
+            format = StreamAudioSource::Format::F32;
+
+        return std::unique_ptr<AudioSource>(new StreamAudioSource(audioPath, format, InitialSettings.audioSampleRate, InitialSettings.inputChannels));
+    }
+
+    try {
+        return std::unique_ptr<AudioSource>(new MappedWaveAudioSource(audioPath));
+    } catch (const FormatException &e) {
+        return std::unique_ptr<AudioSource>(new WaveAudioSource(audioPath));
+    }
+}
+
+/* Generated signal at the sample rate option, without end in realtime mode unless a length is set */
+std::unique_ptr<AudioSource> open_generator() {
+    uint64_t frames = static_cast<uint64_t>(InitialSettings.generateSeconds * InitialSettings.audioSampleRate);
+    return std::unique_ptr<AudioSource>(new GeneratorAudioSource(GeneratorAudioSource::parseSignal(InitialSettings.generateSignal), InitialSettings.audioSampleRate, frames));
+}
+
 void spectrogram_realtime() {
-    ThreadSafeQueue<std::vector<double>> samplesQueue;
-    ThreadSafeQueue<std::vector<uint32_t>> pixelsQueue;
+    std::unique_ptr<AudioSource> audioSource;
+    if (!InitialSettings.generateSignal.empty())
+        audioSource.reset(new PacedAudioSource([]() { return open_generator(); }, InitialSettings.playSpeed, InitialSettings.playLoop));
+    else if (!InitialSettings.playPath.empty())
+        audioSource.reset(new PacedAudioSource([]() { return open_audiofile(InitialSettings.playPath); }, InitialSettings.playSpeed, InitialSettings.playLoop));
+    else if (!InitialSettings.udpAddress.empty())
+        audioSource.reset(new UdpAudioSource(InitialSettings.udpAddress, InitialSettings.audioSampleRate, InitialSettings.inputChannels, InitialSettings.udpJitter));
+    else
+        audioSource.reset(new PulseAudioSource(InitialSettings.audioSampleRate, InitialSettings.audioFragmentSize, InitialSettings.audioLatency, InitialSettings.audioSources.empty() ? "" : InitialSettings.audioSources.front()));
 
-    AudioThread audioThread(samplesQueue, InitialSettings);
-    SpectrogramThread spectrogramThread(samplesQueue, pixelsQueue, InitialSettings);
-    InterfaceThread interfaceThread(pixelsQueue, audioThread, spectrogramThread, InitialSettings);
+    SpectrogramPipeline spectrogramPipeline(*audioSource, {}, InitialSettings);
+    InterfaceThread interfaceThread({&spectrogramPipeline}, {}, InitialSettings);
 
-    audioThread.start();
-    spectrogramThread.start();
+    spectrogramPipeline.start();
     interfaceThread.run();
+    spectrogramPipeline.stop();
+}
 
-    spectrogramThread.stop();
-    audioThread.stop();
+/* Path with an index before its extension, <image>-<index>.<extension> */
+std::string indexed_path(std::string imagePath, unsigned int index) {
+    size_t extension = imagePath.rfind('.');
+    if (extension == std::string::npos || (imagePath.rfind('/') != std::string::npos && imagePath.rfind('/') > extension))
+        extension = imagePath.size();
+    return imagePath.substr(0, extension) + "-" + std::to_string(index) + imagePath.substr(extension);
 }
 
-void spectrogram_audiofile(std::string audioPath, std::string imagePath) {
+/* One image, or an image per channel named <image>-<channel>.<extension> */
+std::vector<std::unique_ptr<ImageSink>> open_images(std::string imagePath, unsigned int inputChannels) {
     unsigned int pixelsWidth = (InitialSettings.orientation == Orientation::Vertical) ? InitialSettings.width : InitialSettings.height;
 
-    WaveAudioSource audioSource(audioPath);
-    RealDft realDft(InitialSettings.dftSize, InitialSettings.dftWf);
-    SpectrumRenderer spectrumRenderer(InitialSettings.magnitudeMin, InitialSettings.magnitudeMax, InitialSettings.magnitudeLog, InitialSettings.colors);
-    MagickImageSink image(imagePath, pixelsWidth, (InitialSettings.orientation == Orientation::Vertical) ? MagickImageSink::Orientation::Vertical : MagickImageSink::Orientation::Horizontal);
+    std::vector<std::unique_ptr<ImageSink>> images;
+    unsigned int channels = ChannelMixer(inputChannels, InitialSettings.channelMode, InitialSettings.channel).getOutputChannels();
+    if (InitialSettings.channelLayout == ChannelLayout::Stacked)
+        channels = 1;
 
-    unsigned int samplesOverlap = static_cast<unsigned int>(InitialSettings.samplesOverlap * static_cast<float>(InitialSettings.dftSize));
+    ImageSink::Orientation orientation = (InitialSettings.orientation == Orientation::Vertical) ? ImageSink::Orientation::Vertical : ImageSink::Orientation::Horizontal;
+    for (unsigned int c = 0; c < channels; c++) {
+        std::string path = (channels > 1) ? indexed_path(imagePath, c) : imagePath;
 
-    /* Overlapped Samples */
-    std::vector<double> overlapSamples(InitialSettings.dftSize);
-    /* DFT of Overlapped Samples */
-    std::vector<std::complex<double>> dftSamples(InitialSettings.dftSize / 2 + 1);
-    /* Pixel line */
-    std::vector<uint32_t> pixels(pixelsWidth);
+        if (is_raw_image(imagePath))
+            images.emplace_back(new RawImageSink(path));
+        else if (is_png_image(imagePath))
+            images.emplace_back(new PngImageSink(path, pixelsWidth, orientation, (InitialSettings.imageThreads > 0) ? InitialSettings.imageThreads : std::max(std::thread::hardware_concurrency(), 1u)));
+        else
+            images.emplace_back(new MagickImageSink(path, pixelsWidth, orientation));
+    }
 
-    while (true) {
-        std::vector<double> audioSamples(overlapSamples.size() - samplesOverlap);
+    return images;
+}
 
-        /* Read audio samples */
-        audioSource.read(audioSamples);
-        if (audioSamples.size() == 0)
-            break;
+/* Several PulseAudio sources captured at once, each with an analysis chain of
+ * its own, in a tile of one window each, or without an interface to an image
+ * each (<image>-<source>.<extension>). The chains share a pool of threads and
+ * the DFT plans, rather than a process each. */
+void spectrogram_sources(std::string imagePath) {
+    size_t count = InitialSettings.audioSources.size();
+    bool headless = !imagePath.empty();
 
-        /* If we're on the final read and short on samples, pad with zeros */
-        if (audioSamples.size() < (overlapSamples.size() - samplesOverlap))
-            audioSamples.resize(overlapSamples.size() - samplesOverlap);
+    /* Tiles share the window */
+    Settings tileSettings = InitialSettings;
+    if (!headless) {
+        unsigned int columns, rows;
+        InterfaceThread::getTileGrid(count, InitialSettings.orientation, columns, rows);
+        tileSettings.width = InitialSettings.width / columns;
+        tileSettings.height = InitialSettings.height / rows;
+    }
 
-        /* Move down overlapSamples.size()-samplesOverlap length old samples */
-        memmove(overlapSamples.data(), overlapSamples.data() + samplesOverlap, sizeof(double) * (overlapSamples.size() - samplesOverlap));
-        /* Copy overlapSamples.size()-samplesOverlap length new samples */
-        memcpy(overlapSamples.data() + samplesOverlap, audioSamples.data(), sizeof(double) * (overlapSamples.size() - samplesOverlap));
+    /* Sources and images outlive the pipelines, and the pipelines the executor */
+    std::vector<std::unique_ptr<AudioSource>> audioSources;
+    std::vector<std::vector<std::unique_ptr<ImageSink>>> images;
+    std::vector<std::unique_ptr<SpectrogramPipeline>> spectrogramPipelines;
+    std::vector<SpectrogramPipeline *> tiles;
+    std::unique_ptr<Pipeline::Executor> executor = SpectrogramPipeline::makeSharedExecutor(tileSettings);
 
-        /* Compute DFT */
-        realDft.compute(dftSamples, overlapSamples);
+    for (size_t i = 0; i < count; i++) {
+        audioSources.emplace_back(new PulseAudioSource(InitialSettings.audioSampleRate, InitialSettings.audioFragmentSize, InitialSettings.audioLatency, InitialSettings.audioSources[i]));
 
-        /* Render spectrogram line */
-        spectrumRenderer.render(pixels, dftSamples);
+        std::vector<ImageSink *> imageSinks;
+        if (headless) {
+            images.push_back(open_images((count > 1) ? indexed_path(imagePath, static_cast<unsigned int>(i)) : imagePath, audioSources.back()->getChannels()));
+            for (auto &image : images.back())
+                imageSinks.push_back(image.get());
+        }
 
-        /* Add pixel row to image */
-        image.append(pixels);
+        spectrogramPipelines.emplace_back(new SpectrogramPipeline(*audioSources.back(), imageSinks, tileSettings, executor.get()));
+        tiles.push_back(spectrogramPipelines.back().get());
     }
 
-    image.write();
+    if (headless) {
+        executor->start();
+        executor->join();
+    } else {
+        InterfaceThread interfaceThread(tiles, InitialSettings.audioSources, tileSettings);
+
+        executor->start();
+        interfaceThread.run();
+        executor->stop();
+    }
+}
+
+/* A file long enough is rendered in time chunks in parallel, a pipeline each
+ * on a source of its own. Chunks start on the hop grid, primed with the
+ * overlap before them like any range, so their rows are the rows of a serial
+ * render. At most a chunk per thread is in flight, and a chunk's rows are
+ * held until the chunks before it are appended. Returns false for a serial
+ * render instead. */
+bool spectrogram_audiofile_chunks(AudioSource &audioSource, std::function<std::unique_ptr<AudioSource>()> reopen, const std::vector<ImageSink *> &imageSinks, const Settings &fileSettings) {
+    unsigned int threads = (fileSettings.fileThreads > 0) ? fileSettings.fileThreads : std::max(std::thread::hardware_concurrency(), 1u);
+    uint64_t frames = audioSource.getFrames();
+
+    /* Streams can't be read twice, and decimators carry state across chunk starts */
+    if (!reopen || threads < 2 || frames == 0 || fileSettings.decimation > 1)
+        return false;
+
+    /* Range rendered */
+    unsigned int sampleRate = audioSource.getSampleRate();
+    uint64_t begin = std::min((fileSettings.startSample > 0) ? fileSettings.startSample : static_cast<uint64_t>(fileSettings.start * sampleRate), frames);
+    uint64_t length = static_cast<uint64_t>(fileSettings.duration * sampleRate);
+    uint64_t end = (length > 0) ? std::min(begin + length, frames) : frames;
+
+    uint64_t hop = fileSettings.dftSize - static_cast<unsigned int>(fileSettings.samplesOverlap * static_cast<float>(fileSettings.dftSize));
+    uint64_t chunkFrames = hop * UserLimits.fileChunkRows;
+    uint64_t count = (end - begin + chunkFrames - 1) / chunkFrames;
+    if (count < 2)
+        return false;
+
+    /* Sources and images outlive the pipelines */
+    struct Chunk {
+        std::unique_ptr<AudioSource> audioSource;
+        std::vector<std::unique_ptr<BufferImageSink>> images;
+        std::unique_ptr<SpectrogramPipeline> pipeline;
+    };
+    std::deque<std::unique_ptr<Chunk>> chunks;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint64_t next = 0; next < count || !chunks.empty();) {
+        /* Keep a chunk per thread in flight */
+        while (next < count && chunks.size() < threads) {
+            std::unique_ptr<Chunk> chunk(new Chunk);
+            chunk->audioSource = reopen();
+
+            std::vector<ImageSink *> chunkSinks;
+            for (size_t i = 0; i < imageSinks.size(); i++) {
+                chunk->images.emplace_back(new BufferImageSink());
+                chunkSinks.push_back(chunk->images.back().get());
+            }
+
+            Settings chunkSettings = fileSettings;
+            chunkSettings.start = chunkSettings.duration = 0.0;
+            chunkSettings.startSample = begin + next * chunkFrames;
+            chunkSettings.durationSamples = std::min(chunkFrames, end - chunkSettings.startSample);
+
+            chunk->pipeline.reset(new SpectrogramPipeline(*chunk->audioSource, chunkSinks, chunkSettings));
+            chunk->pipeline->start();
+            chunks.push_back(std::move(chunk));
+            next++;
+        }
+
+        /* Append the oldest chunk's rows, in order */
+        Chunk &chunk = *chunks.front();
+        chunk.pipeline->join();
+        for (size_t i = 0; i < imageSinks.size(); i++)
+            chunk.images[i]->appendTo(*imageSinks[i]);
+        chunks.pop_front();
+    }
+
+    for (ImageSink *imageSink : imageSinks)
+        imageSink->write();
+
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    if (fileSettings.stats) {
+        std::cerr << "Chunks:          " << count << " of " << chunkFrames << " frames, " << threads << " in parallel\n"
+                  << "Elapsed:         " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms" << std::endl;
+    }
+
+    return true;
+}
+
+/* Render a file, or a range of it, to images. A source that can be opened
+ * again is rendered in parallel chunks, if long enough. */
+void spectrogram_audiofile(std::unique_ptr<AudioSource> audioSource, std::string imagePath, std::function<std::unique_ptr<AudioSource>()> reopen = nullptr) {
+    std::vector<std::unique_ptr<ImageSink>> images = open_images(imagePath, audioSource->getChannels());
+    std::vector<ImageSink *> imageSinks;
+    for (auto &image : images)
+        imageSinks.push_back(image.get());
+
+    /* There is no latency to keep down, read ahead in large blocks */
+    Settings fileSettings = InitialSettings;
+    fileSettings.audioReadSize = InitialSettings.fileReadSize;
+
+    if (spectrogram_audiofile_chunks(*audioSource, reopen, imageSinks, fileSettings))
+        return;
+
+    SpectrogramPipeline spectrogramPipeline(*audioSource, imageSinks, fileSettings);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    spectrogramPipeline.start();
+    spectrogramPipeline.join();
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    if (InitialSettings.stats) {
+        std::cerr << "Read ahead:      " << spectrogramPipeline.getDebugSamplesQueueCapacity() << " blocks of " << fileSettings.audioReadSize << " frames\n"
+                  << "Elapsed:         " << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms\n"
+                  << "Decode waited:   " << spectrogramPipeline.getDebugSamplesProducerWait() << " ms (read ahead full)\n"
+                  << "Spectrum waited: " << spectrogramPipeline.getDebugSamplesConsumerWait() << " ms (read ahead empty)" << std::endl;
+    }
 }
 
 void print_usage(std::string progname) {
     std::cerr << "Real-time Usage: " << progname << " [options]\n"
                  " WAV File Usage: " << progname << " [options] <WAV file input> <image file output>\n"
+                 "   Stream Usage: " << progname << " [options] <- or FIFO input> <image file output or ->\n"
+                 "Generator Usage: " << progname << " [options] --generate <signal> [image file output]\n"
+                 "  Capture Usage: " << progname << " [options] --source <name> [--source <name> ...] --duration <seconds> <image file output>\n"
                  "\n"
                  "Interface Settings\n"
                  "    -h,--help                   Help\n"
@@ -101,15 +306,96 @@ void print_usage(std::string progname) {
                  "    --height <height>           Height of spectrogram (default 480)\n"
                  "    --orientation <orientation> Orientation [horizontal, vertical]\n"
                  "                                    (default vertical)\n"
+                 "    --history <seconds>         Real-time input kept, for a region of a frozen\n"
+                 "                                    display to be analyzed again (default 0)\n"
+                 "    --region-dft-size <size>    DFT Size of regions analyzed again, must be\n"
+                 "                                    power of two (default 8192)\n"
                  "\n"
                  "Audio Settings\n"
                  "    -r,--sample-rate <rate>     Audio input sample rate (default 24000)\n"
+                 "    --read-size <samples>       Audio read size (default 128)\n"
+                 "    --fragment-size <samples>   PulseAudio fragment size (default 256)\n"
+                 "    --read-block <frames>       File read ahead block size (default 16384)\n"
+                 "    --start <seconds>           Start of the range rendered from a file\n"
+                 "    --start-sample <sample>     Start of the range, in samples\n"
+                 "    --duration <seconds>        Length of the range, or of a capture (default to the end)\n"
+                 "    --latency <ms>              PulseAudio target latency, overrides fragment size\n"
+                 "    --source <name>             PulseAudio source captured, instead of the default\n"
+                 "                                    source. Repeat to capture several at once, in\n"
+                 "                                    tiles of one window, or an image each\n"
+                 "    --channels <channels>       Channels analyzed [all, mix, mid, side, <channel>]\n"
+                 "                                    (default all)\n"
+                 "    --input-format <format>     Stream input format [wav, s16, s32, f32]\n"
+                 "                                    (default wav, raw formats take the\n"
+                 "                                    sample rate option)\n"
+                 "    --input-channels <count>    Raw stream and UDP input channels (default 1)\n"
+                 "    --udp <[address:]port>      Real-time input from UDP PCM packets,\n"
+                 "                                    instead of PulseAudio\n"
+                 "    --jitter <ms>               UDP jitter buffer (default 40)\n"
+                 "    --play <WAV file input>     Real-time input played back from a file,\n"
+                 "                                    instead of PulseAudio\n"
+                 "    --speed <speed>             Playback speed, a multiple of real-time,\n"
+                 "                                    or max (default 1)\n"
+                 "    --loop                      Loop playback\n"
+                 "    --generate <signal>         Generated input, instead of PulseAudio or a file\n"
+                 "                                    [tone:<Hz>, comb:<Hz>:<spacing Hz>:<count>,\n"
+                 "                                    chirp:<Hz>:<Hz>:<seconds>, logchirp:<Hz>:<Hz>:<seconds>,\n"
+                 "                                    noise, pink, cw:<Hz>:<wpm>[:<message>]]\n"
+                 "    --generate-seconds <seconds> Length of generated input (default 10 for\n"
+                 "                                    an image, no end in real-time mode)\n"
+                 "    --channel-layout <layout>   Layout of several channels [stacked, separate]\n"
+                 "                                    (default stacked, separate writes\n"
+                 "                                    an image per channel in file mode)\n"
                  "\n"
                  "DFT Settings\n"
                  "    --overlap <percentage>      Samples overlap percentage (default 50)\n"
                  "    --dft-size <size>           DFT Size, must be power of two (default 1024)\n"
                  "    --window <window function>  Window Function [hann, hamming, bartlett, rectangular]\n"
                  "                                  (default hann)\n"
+                 "    --dft-threads <count>       DFT threads, frames are computed in parallel\n"
+                 "                                  and reassembled in order (default 1)\n"
+                 "    --band-start <Hz>           Start of the band analyzed with a decimation\n"
+                 "                                  (default 0)\n"
+                 "    --decimation <factor>       Analyze the band from the band start to the\n"
+                 "                                  sample rate / (2 * factor) above it, at the\n"
+                 "                                  decimated sample rate (default 1)\n"
+                 "\n"
+                 "Pipeline Settings\n"
+                 "    --samples-queue <samples>   Audio samples queue capacity (default 262144)\n"
+                 "    --samples-policy <policy>   Audio samples queue overload policy [block, drop-oldest]\n"
+                 "                                    (default drop-oldest)\n"
+                 "    --pixels-queue <rows>       Pixel rows queue capacity (default 1024)\n"
+                 "    --pixels-policy <policy>    Pixel rows queue overload policy [block, drop-oldest, coalesce]\n"
+                 "                                    (default coalesce)\n"
+                 "    --executor <executor>       Pipeline executor [single, thread-per-stage, pooled]\n"
+                 "                                    (default thread-per-stage, or single for\n"
+                 "                                    files with one DFT thread)\n"
+                 "    --executor-threads <count>  Pooled executor threads (default one per cpu)\n"
+                 "    --file-threads <count>      Threads rendering time chunks of a long file in\n"
+                 "                                  parallel (default one per cpu)\n"
+                 "    --image-threads <count>     Threads compressing a PNG image as it is\n"
+                 "                                  written (default one per cpu)\n"
+                 "    --stats                     Print read ahead wait times after rendering\n"
+                 "                                    a file\n"
+                 "\n"
+                 "Load Shedding Settings\n"
+                 "    --load-shedding <on/off>    Shed work when falling behind, restore it when\n"
+                 "                                  there is headroom again (default on)\n"
+                 "    --shed-overlap <percentage> Lowest overlap when shedding (default 5)\n"
+                 "    --shed-skip <frames>        Compute at least one in this many frames\n"
+                 "                                  when shedding (default 4)\n"
+                 "    --shed-pixel-step <pixels>  Coarsest pixel step when shedding, must be\n"
+                 "                                  power of two (default 4)\n"
+                 "\n"
+                 "Latency Settings\n"
+                 "    --latency-mode              Realtime scheduling for audio and DFT threads,\n"
+                 "                                  locked and pre-faulted memory\n"
+                 "    --scheduler <policy>        Latency mode scheduler [fifo, rr] (default fifo)\n"
+                 "    --audio-priority <priority> Latency mode audio thread priority (default 70)\n"
+                 "    --dft-priority <priority>   Latency mode DFT thread priority (default 60)\n"
+                 "    --audio-cpu <cpu>           Pin audio thread to cpu\n"
+                 "    --dft-cpu <cpu>             Pin DFT thread to cpu\n"
+                 "    --interface-cpu <cpu>       Pin interface thread to cpu\n"
                  "\n"
                  "Spectrogram Settings\n"
                  "    --magnitude-scale <scale>   Magnitude Scale [linear, logarithmic]\n"
@@ -126,6 +412,8 @@ void print_usage(std::string progname) {
                  "    c           - Cycle color scheme\n"
                  "    w           - Cycle window function\n"
                  "    l           - Toggle logarithmic/linear magnitude\n"
+                 "    f           - Freeze/unfreeze display, drag across it to\n"
+                 "                    analyze a region again (with --history)\n"
                  "\n"
                  "    -           - Decrease minimum magnitude\n"
                  "    =           - Increase minimum magnitude\n"
@@ -135,10 +423,14 @@ void print_usage(std::string progname) {
                  "\n"
                  "    Left arrow  - Decrease DFT Size\n"
                  "    Right arrow - Increase DFT Size\n"
+                 "                    (region DFT size and window with w when frozen)\n"
                  "\n"
                  "    Down arrow  - Decrease overlap\n"
                  "    Up arrow    - Increase overlap\n"
                  "\n"
+                 "    ,           - Decrease sample rate (PulseAudio)\n"
+                 "    .           - Increase sample rate (PulseAudio)\n"
+                 "\n"
                  "audioprism v1.0.1 - https://github.com/vsergeev/audioprism" << std::endl;
 }
 
@@ -151,14 +443,59 @@ int main(int argc, char *argv[]) {
         {"width", required_argument, 0, 0},
         {"height", required_argument, 0, 0},
         {"orientation", required_argument, 0, 0},
+        {"history", required_argument, 0, 0},
+        {"region-dft-size", required_argument, 0, 0},
         {"sample-rate", required_argument, 0, 'r'},
         {"overlap", required_argument, 0, 0},
         {"dft-size", required_argument, 0, 0},
         {"window", required_argument, 0, 0},
+        {"dft-threads", required_argument, 0, 0},
+        {"band-start", required_argument, 0, 0},
+        {"decimation", required_argument, 0, 0},
         {"magnitude-scale", required_argument, 0, 0},
         {"magnitude-min", required_argument, 0, 0},
         {"magnitude-max", required_argument, 0, 0},
         {"colors", required_argument, 0, 0},
+        {"samples-queue", required_argument, 0, 0},
+        {"samples-policy", required_argument, 0, 0},
+        {"pixels-queue", required_argument, 0, 0},
+        {"pixels-policy", required_argument, 0, 0},
+        {"executor", required_argument, 0, 0},
+        {"executor-threads", required_argument, 0, 0},
+        {"file-threads", required_argument, 0, 0},
+        {"image-threads", required_argument, 0, 0},
+        {"load-shedding", required_argument, 0, 0},
+        {"shed-overlap", required_argument, 0, 0},
+        {"shed-skip", required_argument, 0, 0},
+        {"shed-pixel-step", required_argument, 0, 0},
+        {"read-size", required_argument, 0, 0},
+        {"fragment-size", required_argument, 0, 0},
+        {"read-block", required_argument, 0, 0},
+        {"start", required_argument, 0, 0},
+        {"start-sample", required_argument, 0, 0},
+        {"duration", required_argument, 0, 0},
+        {"stats", no_argument, 0, 0},
+        {"latency", required_argument, 0, 0},
+        {"source", required_argument, 0, 0},
+        {"channels", required_argument, 0, 0},
+        {"input-format", required_argument, 0, 0},
+        {"input-channels", required_argument, 0, 0},
+        {"udp", required_argument, 0, 0},
+        {"jitter", required_argument, 0, 0},
+        {"play", required_argument, 0, 0},
+        {"speed", required_argument, 0, 0},
+        {"loop", no_argument, 0, 0},
+        {"generate", required_argument, 0, 0},
+        {"generate-seconds", required_argument, 0, 0},
+        {"channel-layout", required_argument, 0, 0},
+        {"latency-mode", no_argument, 0, 0},
+        {"scheduler", required_argument, 0, 0},
+        {"audio-priority", required_argument, 0, 0},
+        {"dft-priority", required_argument, 0, 0},
+        {"audio-cpu", required_argument, 0, 0},
+        {"dft-cpu", required_argument, 0, 0},
+        {"interface-cpu", required_argument, 0, 0},
+        {0, 0, 0, 0},
     };
 
     while (1) {
@@ -247,6 +584,40 @@ int main(int argc, char *argv[]) {
                 }
 
                 InitialSettings.dftSize = dftSize;
+            } else if (option_name == "region-dft-size") {
+                unsigned int dftSize;
+                try {
+                    dftSize = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for region DFT size.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if ((dftSize & (dftSize - 1)) != 0 || dftSize < UserLimits.dftSizeMin || dftSize > UserLimits.regionDftSizeMax) {
+                    std::cerr << "Invalid value for region DFT size (must be power of 2 and >= " << UserLimits.dftSizeMin << " and <= " << UserLimits.regionDftSizeMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.regionDftSize = dftSize;
+            } else if (option_name == "history") {
+                double seconds;
+                try {
+                    seconds = std::stod(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for history.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (seconds < 0 || seconds > UserLimits.historySecondsMax) {
+                    std::cerr << "Invalid value for history (must be >= 0 and <= " << UserLimits.historySecondsMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.historySeconds = seconds;
             } else if (option_name == "window") {
                 if (option_arg == "hann")
                     InitialSettings.dftWf = RealDft::WindowFunction::Hann;
@@ -261,6 +632,57 @@ int main(int argc, char *argv[]) {
                     print_usage(argv[0]);
                     return EXIT_FAILURE;
                 }
+            } else if (option_name == "dft-threads") {
+                unsigned int dftThreads;
+                try {
+                    dftThreads = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for DFT threads.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (dftThreads < 1 || dftThreads > UserLimits.dftThreadsMax) {
+                    std::cerr << "Invalid value for DFT threads (must be >= 1 and <= " << UserLimits.dftThreadsMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.dftThreads = dftThreads;
+            } else if (option_name == "band-start") {
+                double bandStart;
+                try {
+                    bandStart = std::stod(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for band start.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (bandStart < 0) {
+                    std::cerr << "Invalid value for band start (must be >= 0).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.bandStart = bandStart;
+            } else if (option_name == "decimation") {
+                unsigned int decimation;
+                try {
+                    decimation = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for decimation.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (decimation < 1 || decimation > UserLimits.decimationMax) {
+                    std::cerr << "Invalid value for decimation (must be >= 1 and <= " << UserLimits.decimationMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.decimation = decimation;
             } else if (option_name == "magnitude-scale") {
                 if (option_arg == "logarithmic")
                     InitialSettings.magnitudeLog = true;
@@ -287,6 +709,452 @@ int main(int argc, char *argv[]) {
                     print_usage(argv[0]);
                     return EXIT_FAILURE;
                 }
+            } else if (option_name == "samples-queue" || option_name == "pixels-queue") {
+                size_t capacity;
+                try {
+                    capacity = static_cast<size_t>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for queue capacity.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (capacity == 0) {
+                    std::cerr << "Invalid value for queue capacity (must be > 0).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (option_name == "samples-queue")
+                    InitialSettings.samplesQueueCapacity = capacity;
+                else
+                    InitialSettings.pixelsQueueCapacity = capacity;
+            } else if (option_name == "samples-policy") {
+                if (option_arg == "block")
+                    InitialSettings.samplesQueuePolicy = QueuePolicy::Block;
+                else if (option_arg == "drop-oldest")
+                    InitialSettings.samplesQueuePolicy = QueuePolicy::DropOldest;
+                else {
+                    std::cerr << "Invalid samples queue policy.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "pixels-policy") {
+                if (option_arg == "block")
+                    InitialSettings.pixelsQueuePolicy = QueuePolicy::Block;
+                else if (option_arg == "drop-oldest")
+                    InitialSettings.pixelsQueuePolicy = QueuePolicy::DropOldest;
+                else if (option_arg == "coalesce")
+                    InitialSettings.pixelsQueuePolicy = QueuePolicy::Coalesce;
+                else {
+                    std::cerr << "Invalid pixels queue policy.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "executor") {
+                if (option_arg == "single")
+                    InitialSettings.executor = Executor::Single;
+                else if (option_arg == "thread-per-stage")
+                    InitialSettings.executor = Executor::ThreadPerStage;
+                else if (option_arg == "pooled")
+                    InitialSettings.executor = Executor::Pooled;
+                else {
+                    std::cerr << "Invalid executor.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "executor-threads") {
+                unsigned int executorThreads;
+                try {
+                    executorThreads = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for executor threads.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (executorThreads < 1 || executorThreads > UserLimits.executorThreadsMax) {
+                    std::cerr << "Invalid value for executor threads (must be >= 1 and <= " << UserLimits.executorThreadsMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.executorThreads = executorThreads;
+            } else if (option_name == "read-size" || option_name == "fragment-size") {
+                unsigned int size;
+                try {
+                    size = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for " << option_name << ".\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (size == 0) {
+                    std::cerr << "Invalid value for " << option_name << " (must be > 0).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (option_name == "read-size")
+                    InitialSettings.audioReadSize = size;
+                else
+                    InitialSettings.audioFragmentSize = size;
+            } else if (option_name == "read-block") {
+                unsigned int size;
+                try {
+                    size = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for read block.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (size < 1 || size > UserLimits.fileReadSizeMax) {
+                    std::cerr << "Invalid value for read block (must be >= 1 and <= " << UserLimits.fileReadSizeMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.fileReadSize = size;
+            } else if (option_name == "file-threads") {
+                unsigned int fileThreads;
+                try {
+                    fileThreads = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for file threads.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (fileThreads < 1 || fileThreads > UserLimits.fileThreadsMax) {
+                    std::cerr << "Invalid value for file threads (must be >= 1 and <= " << UserLimits.fileThreadsMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.fileThreads = fileThreads;
+            } else if (option_name == "image-threads") {
+                unsigned int imageThreads;
+                try {
+                    imageThreads = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for image threads.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (imageThreads < 1 || imageThreads > UserLimits.imageThreadsMax) {
+                    std::cerr << "Invalid value for image threads (must be >= 1 and <= " << UserLimits.imageThreadsMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.imageThreads = imageThreads;
+            } else if (option_name == "start" || option_name == "duration") {
+                double seconds;
+                try {
+                    seconds = std::stod(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for " << option_name << ".\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (seconds < 0 || (option_name == "duration" && seconds == 0)) {
+                    std::cerr << "Invalid value for " << option_name << " (must be " << ((option_name == "start") ? ">= 0" : "> 0") << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (option_name == "start")
+                    InitialSettings.start = seconds;
+                else
+                    InitialSettings.duration = seconds;
+            } else if (option_name == "start-sample") {
+                try {
+                    InitialSettings.startSample = std::stoull(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for start sample.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "stats") {
+                InitialSettings.stats = true;
+            } else if (option_name == "latency") {
+                unsigned int latency;
+                try {
+                    latency = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for latency.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (latency == 0) {
+                    std::cerr << "Invalid value for latency (must be > 0).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.audioLatency = latency;
+            } else if (option_name == "channels") {
+                if (option_arg == "all") {
+                    InitialSettings.channelMode = ChannelMixer::Mode::All;
+                } else if (option_arg == "mix") {
+                    InitialSettings.channelMode = ChannelMixer::Mode::Mix;
+                } else if (option_arg == "mid") {
+                    InitialSettings.channelMode = ChannelMixer::Mode::Mid;
+                } else if (option_arg == "side") {
+                    InitialSettings.channelMode = ChannelMixer::Mode::Side;
+                } else {
+                    try {
+                        InitialSettings.channel = static_cast<unsigned int>(std::stoul(option_arg));
+                        InitialSettings.channelMode = ChannelMixer::Mode::Single;
+                    } catch (const std::invalid_argument &e) {
+                        std::cerr << "Invalid value for channels.\n\n";
+                        print_usage(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+            } else if (option_name == "input-format") {
+                if (option_arg == "wav")
+                    InitialSettings.inputFormat = InputFormat::Wav;
+                else if (option_arg == "s16")
+                    InitialSettings.inputFormat = InputFormat::S16;
+                else if (option_arg == "s32")
+                    InitialSettings.inputFormat = InputFormat::S32;
+                else if (option_arg == "f32")
+                    InitialSettings.inputFormat = InputFormat::F32;
+                else {
+                    std::cerr << "Invalid input format.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "input-channels") {
+                unsigned int inputChannels;
+                try {
+                    inputChannels = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for input channels.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (inputChannels < 1 || inputChannels > UserLimits.inputChannelsMax) {
+                    std::cerr << "Invalid value for input channels (must be >= 1 and <= " << UserLimits.inputChannelsMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.inputChannels = inputChannels;
+            } else if (option_name == "source") {
+                if (InitialSettings.audioSources.size() == UserLimits.audioSourcesMax) {
+                    std::cerr << "Invalid value for source (at most " << UserLimits.audioSourcesMax << " sources).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.audioSources.push_back(option_arg);
+            } else if (option_name == "udp") {
+                InitialSettings.udpAddress = option_arg;
+            } else if (option_name == "play") {
+                InitialSettings.playPath = option_arg;
+            } else if (option_name == "speed") {
+                double speed;
+                if (option_arg == "max") {
+                    speed = 0;
+                } else {
+                    try {
+                        speed = std::stod(option_arg);
+                    } catch (const std::invalid_argument &e) {
+                        std::cerr << "Invalid value for speed.\n\n";
+                        print_usage(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+
+                    if (speed <= 0 || speed > UserLimits.playSpeedMax) {
+                        std::cerr << "Invalid value for speed (must be > 0 and <= " << UserLimits.playSpeedMax << ", or max).\n\n";
+                        print_usage(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+
+                InitialSettings.playSpeed = speed;
+            } else if (option_name == "loop") {
+                InitialSettings.playLoop = true;
+            } else if (option_name == "generate") {
+                try {
+                    GeneratorAudioSource::parseSignal(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for generated signal.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.generateSignal = option_arg;
+            } else if (option_name == "generate-seconds") {
+                double seconds;
+                try {
+                    seconds = std::stod(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for generate seconds.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (seconds <= 0) {
+                    std::cerr << "Invalid value for generate seconds (must be > 0).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.generateSeconds = seconds;
+            } else if (option_name == "jitter") {
+                unsigned int jitter;
+                try {
+                    jitter = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for jitter.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (jitter < 1 || jitter > UserLimits.udpJitterMax) {
+                    std::cerr << "Invalid value for jitter (must be >= 1 and <= " << UserLimits.udpJitterMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.udpJitter = jitter;
+            } else if (option_name == "channel-layout") {
+                if (option_arg == "stacked")
+                    InitialSettings.channelLayout = ChannelLayout::Stacked;
+                else if (option_arg == "separate")
+                    InitialSettings.channelLayout = ChannelLayout::Separate;
+                else {
+                    std::cerr << "Invalid channel layout.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "load-shedding") {
+                if (option_arg == "on")
+                    InitialSettings.loadShedding = true;
+                else if (option_arg == "off")
+                    InitialSettings.loadShedding = false;
+                else {
+                    std::cerr << "Invalid value for load shedding.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "shed-overlap") {
+                unsigned int shedOverlap;
+                try {
+                    shedOverlap = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for shedding overlap.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                unsigned int overlapMin = static_cast<unsigned int>(std::round(UserLimits.samplesOverlapMin * 100.0));
+                unsigned int overlapMax = static_cast<unsigned int>(std::round(UserLimits.samplesOverlapMax * 100.0));
+
+                if (shedOverlap < overlapMin || shedOverlap > overlapMax) {
+                    std::cerr << "Invalid value for shedding overlap (must be >= " << overlapMin << " and <= " << overlapMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.loadSheddingOverlapMin = static_cast<float>(shedOverlap) / 100.0f;
+            } else if (option_name == "shed-skip") {
+                unsigned int shedSkip;
+                try {
+                    shedSkip = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for shedding frame skip.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (shedSkip < 1 || shedSkip > UserLimits.loadSheddingSkipMax) {
+                    std::cerr << "Invalid value for shedding frame skip (must be >= 1 and <= " << UserLimits.loadSheddingSkipMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.loadSheddingSkipMax = shedSkip;
+            } else if (option_name == "shed-pixel-step") {
+                unsigned int shedPixelStep;
+                try {
+                    shedPixelStep = static_cast<unsigned int>(std::stoul(option_arg));
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for shedding pixel step.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (shedPixelStep == 0 || (shedPixelStep & (shedPixelStep - 1)) != 0 || shedPixelStep > UserLimits.loadSheddingPixelStepMax) {
+                    std::cerr << "Invalid value for shedding pixel step (must be power of 2 and <= " << UserLimits.loadSheddingPixelStepMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                InitialSettings.loadSheddingPixelStepMax = shedPixelStep;
+            } else if (option_name == "latency-mode") {
+                InitialSettings.latencyMode = true;
+            } else if (option_name == "scheduler") {
+                if (option_arg == "fifo")
+                    InitialSettings.latencyScheduler = Realtime::Scheduler::Fifo;
+                else if (option_arg == "rr")
+                    InitialSettings.latencyScheduler = Realtime::Scheduler::RoundRobin;
+                else {
+                    std::cerr << "Invalid scheduler.\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            } else if (option_name == "audio-priority" || option_name == "dft-priority") {
+                int priority;
+                try {
+                    priority = std::stoi(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for " << option_name << ".\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (priority < UserLimits.schedulerPriorityMin || priority > UserLimits.schedulerPriorityMax) {
+                    std::cerr << "Invalid value for " << option_name << " (must be >= " << UserLimits.schedulerPriorityMin << " and <= " << UserLimits.schedulerPriorityMax << ").\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (option_name == "audio-priority")
+                    InitialSettings.audioPriority = priority;
+                else
+                    InitialSettings.dftPriority = priority;
+            } else if (option_name == "audio-cpu" || option_name == "dft-cpu" || option_name == "interface-cpu") {
+                int cpu;
+                try {
+                    cpu = std::stoi(option_arg);
+                } catch (const std::invalid_argument &e) {
+                    std::cerr << "Invalid value for " << option_name << ".\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (cpu < 0) {
+                    std::cerr << "Invalid value for " << option_name << " (must be >= 0).\n\n";
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                if (option_name == "audio-cpu")
+                    InitialSettings.audioCpu = cpu;
+                else if (option_name == "dft-cpu")
+                    InitialSettings.dftCpu = cpu;
+                else
+                    InitialSettings.interfaceCpu = cpu;
             } else if (option_name == "colors") {
                 if (option_arg == "logarithmic")
                     InitialSettings.magnitudeLog = true;
@@ -324,25 +1192,84 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if ((argc - optind) > 0 && (argc - optind) != 2) {
+    if (InitialSettings.bandStart > 0 && InitialSettings.decimation == 1)
+        std::cerr << "warning: band start option ignored. the full band is analyzed without a decimation." << std::endl;
+
+    /* Sources are captured from PulseAudio, not another input */
+    bool generated = !InitialSettings.generateSignal.empty();
+    if (!InitialSettings.audioSources.empty() && (generated || !InitialSettings.playPath.empty() || !InitialSettings.udpAddress.empty())) {
+        std::cerr << "warning: source option ignored. sources are captured from PulseAudio, not another input." << std::endl;
+        InitialSettings.audioSources.clear();
+    }
+
+    /* A generated input, or sources captured, take the place of the audio file */
+    bool captured = !InitialSettings.audioSources.empty();
+    int fileArguments = (generated || captured) ? 1 : 2;
+
+    if ((argc - optind) > 0 && (argc - optind) != fileArguments) {
         print_usage(argv[0]);
         return EXIT_FAILURE;
     }
 
     /* Audio file mode */
-    if ((argc - optind) == 2) {
-        if (sampleRateConfigured)
+    if ((argc - optind) == fileArguments) {
+        std::string imagePath = argv[argc - 1];
+        bool rawInput = InitialSettings.inputFormat != InputFormat::Auto && InitialSettings.inputFormat != InputFormat::Wav;
+        if (sampleRateConfigured && !rawInput && !generated && !captured)
             std::cerr << "warning: sample rate option ignored. sample rate is determined by audio file." << std::endl;
+        if (imagePath == "-" && InitialSettings.channelLayout == ChannelLayout::Separate) {
+            std::cerr << "warning: separate channel layout ignored. channels are stacked on stdout." << std::endl;
+            InitialSettings.channelLayout = ChannelLayout::Stacked;
+        }
         if (InitialSettings.orientation == Orientation::Vertical && heightConfigured)
             std::cerr << "warning: height option ignored. height in vertical orientation is determined by audio length and samples overlap percentage." << std::endl;
         if (InitialSettings.orientation == Orientation::Horizontal && widthConfigured)
             std::cerr << "warning: width option ignored. width in horizontal orientation is determined by audio length and samples overlap percentage." << std::endl;
 
-        spectrogram_audiofile(std::string(argv[optind]), std::string(argv[optind + 1]));
+        if (captured) {
+            if (imagePath == "-" && InitialSettings.audioSources.size() > 1) {
+                std::cerr << "Several sources can't be written to stdout.\n\n";
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (InitialSettings.duration == 0) {
+                std::cerr << "Capturing sources to an image needs a duration.\n\n";
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (InitialSettings.start > 0 || InitialSettings.startSample > 0) {
+                std::cerr << "warning: start option ignored. sources are captured from now." << std::endl;
+                InitialSettings.start = 0;
+                InitialSettings.startSample = 0;
+            }
+            spectrogram_sources(imagePath);
+        } else if (generated) {
+            if (InitialSettings.generateSeconds == 0)
+                InitialSettings.generateSeconds = UserLimits.generateSecondsImage;
+            spectrogram_audiofile(open_generator(), imagePath);
+        } else {
+            std::string audioPath = argv[optind];
+            spectrogram_audiofile(open_audiofile(audioPath), imagePath, [&]() { return open_audiofile(audioPath); });
+        }
 
         /* Realtime mode */
     } else {
-        spectrogram_realtime();
+        if (!InitialSettings.playPath.empty() && sampleRateConfigured)
+            std::cerr << "warning: sample rate option ignored. sample rate is determined by played back audio file." << std::endl;
+        if (InitialSettings.start > 0 || InitialSettings.startSample > 0 || InitialSettings.duration > 0) {
+            std::cerr << "warning: start and duration options ignored. they select a range of a file to render to an image." << std::endl;
+            InitialSettings.start = InitialSettings.duration = 0;
+            InitialSettings.startSample = 0;
+        }
+        if (InitialSettings.channelLayout == ChannelLayout::Separate) {
+            std::cerr << "warning: separate channel layout ignored. channels are stacked in real-time mode." << std::endl;
+            InitialSettings.channelLayout = ChannelLayout::Stacked;
+        }
+
+        if (InitialSettings.audioSources.size() > 1)
+            spectrogram_sources("");
+        else
+            spectrogram_realtime();
     }
 
     return 0;
@@ -0,0 +1,59 @@
+#include <new>
+#include <cstdlib>
+
+#include "AllocationCounter.hpp"
+
+/* Per-thread counter, set by threads that want their heap allocations counted */
+static thread_local std::atomic<size_t> *threadCounter = nullptr;
+
+namespace AllocationCounter {
+
+void track(std::atomic<size_t> &counter) {
+    threadCounter = &counter;
+}
+}
+
+static void *countedAllocate(size_t size) {
+    if (threadCounter)
+        threadCounter->fetch_add(1, std::memory_order_relaxed);
+
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new(size_t size) {
+    void *p = countedAllocate(size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    void *p = countedAllocate(size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return countedAllocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return countedAllocate(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,13 @@
+#ifndef _ALLOCATIONCOUNTER_HPP
+#define _ALLOCATIONCOUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace AllocationCounter {
+
+/* Count heap allocations made by the calling thread into counter */
+void track(std::atomic<size_t> &counter);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef _BUFFERPOOL_HPP
+#define _BUFFERPOOL_HPP
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include "SpscRingBuffer.hpp"
+
+/* Pooled buffer with stream metadata. An empty buffer marks the end of the stream. */
+template <typename T>
+struct Buffer {
+    std::vector<T> data;
+    /* Sequence number of this buffer in its stream */
+    uint64_t sequence = 0;
+    /* Sample position of the first element in the source stream, in frames */
+    uint64_t position = 0;
+    /* Samples of the source stream it spans from position, for frames and
+     * rows the DFT size of their window */
+    unsigned int span = 0;
+    /* Channel of the source stream it carries, for planar buffers */
+    unsigned int channel = 0;
+    /* Sample rate of the source stream */
+    unsigned int sampleRate = 0;
+    /* Capture time of the newest sample it carries, the epoch if unknown */
+    std::chrono::steady_clock::time_point timestamp;
+};
+
+/* Fixed-size pool of pre-allocated buffers. Buffers are acquired by one
+ * thread and released by another, so the free list is itself a SPSC ring. */
+template <typename T>
+class BufferPool {
+  public:
+    BufferPool(size_t count, size_t size);
+
+    /* Acquire a free buffer (acquiring thread only), nullptr if none are free */
+    Buffer<T> *acquire();
+    /* Release a buffer back to the pool (releasing thread only) */
+    void release(Buffer<T> *buffer);
+
+    /* Block until a buffer is free, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool wait(const std::chrono::duration<Rep, Period> &rel_time);
+
+    size_t available();
+    size_t count();
+
+  private:
+    std::vector<std::unique_ptr<Buffer<T>>> buffers;
+    SpscRingBuffer<Buffer<T> *> freeList;
+};
+
+template <typename T>
+BufferPool<T>::BufferPool(size_t count, size_t size) : freeList(count) {
+    for (size_t i = 0; i < count; i++) {
+        buffers.emplace_back(new Buffer<T>());
+        buffers.back()->data.resize(size);
+
+        Buffer<T> *buffer = buffers.back().get();
+        freeList.write(&buffer, 1);
+    }
+}
+
+template <typename T>
+Buffer<T> *BufferPool<T>::acquire() {
+    Buffer<T> *buffer = nullptr;
+    freeList.read(&buffer, 1);
+    return buffer;
+}
+
+template <typename T>
+void BufferPool<T>::release(Buffer<T> *buffer) {
+    freeList.write(&buffer, 1);
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool BufferPool<T>::wait(const std::chrono::duration<Rep, Period> &rel_time) {
+    return freeList.waitReadable(1, rel_time);
+}
+
+template <typename T>
+size_t BufferPool<T>::available() {
+    return freeList.count();
+}
+
+template <typename T>
+size_t BufferPool<T>::count() {
+    return buffers.size();
+}
+
+#endif
@@ -0,0 +1,295 @@
+#ifndef _BUFFERQUEUE_HPP
+#define _BUFFERQUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include "CacheAligned.hpp"
+#include "BufferPool.hpp"
+#include "EventCount.hpp"
+
+/* What the producer does when the queue is full */
+enum class QueuePolicy { Block,
+                         DropOldest,
+                         Coalesce };
+
+/* Merge a buffer that didn't fit into the queue into a pending one */
+template <typename T>
+static void coalesceBuffers(std::vector<T> &into, const std::vector<T> &from) {
+    for (size_t i = 0; i < into.size() && i < from.size(); i++)
+        into[i] = std::max(into[i], from[i]);
+}
+
+/* Pixel rows are packed RGB, hold the peak of each channel */
+static inline void coalesceBuffers(std::vector<uint32_t> &into, const std::vector<uint32_t> &from) {
+    for (size_t i = 0; i < into.size() && i < from.size(); i++)
+        into[i] = std::max(into[i] & 0xff0000u, from[i] & 0xff0000u) | std::max(into[i] & 0xff00u, from[i] & 0xff00u) | std::max(into[i] & 0xffu, from[i] & 0xffu);
+}
+
+/* Add the time since a side of a queue started waiting to its total when it
+ * stops waiting. Only the side's own thread touches waiting and since. */
+static inline void accountWait(bool waitingNow, bool &waiting, std::chrono::steady_clock::time_point &since, std::atomic<uint64_t> &total) {
+    if (waitingNow == waiting)
+        return;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (waitingNow)
+        since = now;
+    else
+        total += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - since).count());
+    waiting = waitingNow;
+}
+
+/* Bounded zero-copy link between a producer and a consumer thread. The
+ * producer acquires a pooled buffer, fills it in place and pushes it; the
+ * consumer pops it, uses it in place and releases it back to the pool.
+ *
+ * When the queue is full, acquire() either blocks (Block), takes the oldest
+ * queued buffer back from the consumer's end (DropOldest), or hands out a
+ * scratch buffer whose contents are merged into one pending buffer that is
+ * queued once there is room again (Coalesce). */
+template <typename T>
+class BufferQueue : public CacheAligned<BufferQueue<T>> {
+  public:
+    BufferQueue(size_t capacity, size_t bufferSize, QueuePolicy policy = QueuePolicy::Block);
+
+    /* Producer: acquire a buffer to fill, waiting up to rel_time, nullptr on timeout */
+    template <typename Rep, typename Period>
+    Buffer<T> *acquire(const std::chrono::duration<Rep, Period> &rel_time);
+    /* Producer: acquire a buffer to fill without waiting, nullptr if none */
+    Buffer<T> *acquire();
+    /* Producer: push a filled buffer */
+    void push(Buffer<T> *buffer);
+    /* Producer: block until acquire() won't block, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool waitWritable(const std::chrono::duration<Rep, Period> &rel_time);
+
+    /* Consumer: pop a buffer, waiting up to rel_time, nullptr on timeout */
+    template <typename Rep, typename Period>
+    Buffer<T> *pop(const std::chrono::duration<Rep, Period> &rel_time);
+    /* Consumer: pop a buffer without waiting, nullptr if empty */
+    Buffer<T> *pop();
+    /* Consumer: release a used buffer back to the pool */
+    void release(Buffer<T> *buffer);
+    /* Consumer: block until a buffer is queued, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool waitReadable(const std::chrono::duration<Rep, Period> &rel_time);
+
+    size_t count();
+    size_t capacity();
+    QueuePolicy getPolicy();
+
+    /* Buffers and elements lost to the overload policy */
+    size_t getDroppedBuffers();
+    size_t getDroppedElements();
+
+    /* Time the producer found the queue full, and the consumer found it
+     * empty, in microseconds */
+    uint64_t getProducerWait();
+    uint64_t getConsumerWait();
+
+  private:
+    /* Take the oldest queued buffer, from either side */
+    Buffer<T> *take();
+    /* Producer: acquire a buffer without waiting or accounting for it */
+    Buffer<T> *tryAcquire();
+
+    const QueuePolicy policy;
+
+    /* Pool holds exactly as many buffers as the queue has slots */
+    BufferPool<T> pool;
+
+    /* Ring of queued buffers. Slots are atomic and the tail advances by
+     * compare-exchange, so the producer can take the oldest buffer back. */
+    const size_t mask;
+    std::unique_ptr<std::atomic<Buffer<T> *>[]> slots;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) EventCount notEmpty;
+
+    /* Producer-only buffers for coalescing */
+    Buffer<T> scratch;
+    Buffer<T> pending;
+    bool pendingValid;
+
+    std::atomic<size_t> droppedBuffers;
+    std::atomic<size_t> droppedElements;
+
+    /* Producer-only and consumer-only wait accounting */
+    bool producerWaiting;
+    std::chrono::steady_clock::time_point producerWaitingSince;
+    bool consumerWaiting;
+    std::chrono::steady_clock::time_point consumerWaitingSince;
+    std::atomic<uint64_t> producerWait;
+    std::atomic<uint64_t> consumerWait;
+};
+
+template <typename T>
+BufferQueue<T>::BufferQueue(size_t capacity, size_t bufferSize, QueuePolicy policy) : policy(policy), pool(roundUpPowerOfTwo(capacity), bufferSize), mask(roundUpPowerOfTwo(capacity) - 1), slots(new std::atomic<Buffer<T> *>[mask + 1]), head(0), tail(0), pendingValid(false), droppedBuffers(0), droppedElements(0), producerWaiting(false), consumerWaiting(false), producerWait(0), consumerWait(0) {
+    if (policy == QueuePolicy::Coalesce) {
+        scratch.data.resize(bufferSize);
+        pending.data.resize(bufferSize);
+    }
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+Buffer<T> *BufferQueue<T>::acquire(const std::chrono::duration<Rep, Period> &rel_time) {
+    Buffer<T> *buffer = acquire();
+    if (buffer != nullptr)
+        return buffer;
+
+    /* Block, or every buffer is held by the consumer */
+    if (!pool.wait(rel_time))
+        return nullptr;
+    buffer = pool.acquire();
+    accountWait(buffer == nullptr, producerWaiting, producerWaitingSince, producerWait);
+    return buffer;
+}
+
+template <typename T>
+Buffer<T> *BufferQueue<T>::acquire() {
+    Buffer<T> *buffer = tryAcquire();
+    accountWait(buffer == nullptr, producerWaiting, producerWaitingSince, producerWait);
+    return buffer;
+}
+
+template <typename T>
+Buffer<T> *BufferQueue<T>::tryAcquire() {
+    Buffer<T> *buffer = pool.acquire();
+    if (buffer != nullptr)
+        return buffer;
+
+    if (policy == QueuePolicy::DropOldest) {
+        /* Reuse the oldest queued buffer */
+        if ((buffer = take()) != nullptr) {
+            droppedBuffers++;
+            droppedElements += buffer->data.size();
+            return buffer;
+        }
+    } else if (policy == QueuePolicy::Coalesce) {
+        return &scratch;
+    }
+
+    return nullptr;
+}
+
+template <typename T>
+void BufferQueue<T>::push(Buffer<T> *buffer) {
+    if (buffer == &scratch) {
+        /* Queue is full, fold this buffer into the pending one */
+        if (!pendingValid) {
+            std::swap(pending, scratch);
+            pendingValid = true;
+        } else {
+            coalesceBuffers(pending.data, scratch.data);
+            droppedBuffers++;
+            droppedElements += scratch.data.size();
+        }
+        return;
+    }
+
+    if (pendingValid) {
+        /* There is room again, queue everything coalesced so far as this buffer */
+        coalesceBuffers(buffer->data, pending.data);
+        droppedBuffers++;
+        droppedElements += pending.data.size();
+        pendingValid = false;
+    }
+
+    /* Can't overflow: the pool never hands out more buffers than there are slots */
+    size_t h = head.load(std::memory_order_relaxed);
+    slots[h & mask].store(buffer, std::memory_order_relaxed);
+    head.store(h + 1, std::memory_order_release);
+
+    notEmpty.notify();
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool BufferQueue<T>::waitWritable(const std::chrono::duration<Rep, Period> &rel_time) {
+    /* Coalesce always has the scratch buffer, DropOldest has any queued buffer */
+    if (policy == QueuePolicy::Coalesce || (policy == QueuePolicy::DropOldest && count() > 0))
+        return true;
+    return pool.wait(rel_time);
+}
+
+template <typename T>
+Buffer<T> *BufferQueue<T>::take() {
+    size_t t = tail.load(std::memory_order_acquire);
+
+    while (t != head.load(std::memory_order_acquire)) {
+        Buffer<T> *buffer = slots[t & mask].load(std::memory_order_relaxed);
+        /* Only valid if nobody took it first */
+        if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            return buffer;
+    }
+
+    return nullptr;
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+Buffer<T> *BufferQueue<T>::pop(const std::chrono::duration<Rep, Period> &rel_time) {
+    waitReadable(rel_time);
+    return pop();
+}
+
+template <typename T>
+Buffer<T> *BufferQueue<T>::pop() {
+    Buffer<T> *buffer = take();
+    accountWait(buffer == nullptr, consumerWaiting, consumerWaitingSince, consumerWait);
+    return buffer;
+}
+
+template <typename T>
+void BufferQueue<T>::release(Buffer<T> *buffer) {
+    pool.release(buffer);
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool BufferQueue<T>::waitReadable(const std::chrono::duration<Rep, Period> &rel_time) {
+    return notEmpty.waitFor([this]() { return this->count() > 0; }, rel_time);
+}
+
+template <typename T>
+size_t BufferQueue<T>::count() {
+    /* Load tail first, so head can only be ahead of it */
+    size_t t = tail.load(std::memory_order_acquire);
+    return head.load(std::memory_order_acquire) - t;
+}
+
+template <typename T>
+size_t BufferQueue<T>::capacity() {
+    return mask + 1;
+}
+
+template <typename T>
+QueuePolicy BufferQueue<T>::getPolicy() {
+    return policy;
+}
+
+template <typename T>
+size_t BufferQueue<T>::getDroppedBuffers() {
+    return droppedBuffers;
+}
+
+template <typename T>
+size_t BufferQueue<T>::getDroppedElements() {
+    return droppedElements;
+}
+
+template <typename T>
+uint64_t BufferQueue<T>::getProducerWait() {
+    return producerWait;
+}
+
+template <typename T>
+uint64_t BufferQueue<T>::getConsumerWait() {
+    return consumerWait;
+}
+
+#endif
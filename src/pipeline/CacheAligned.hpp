@@ -0,0 +1,29 @@
+#ifndef _CACHEALIGNED_HPP
+#define _CACHEALIGNED_HPP
+
+#include <new>
+#include <cstdlib>
+
+/* Base of a class T with cache line aligned members (queue or ring indices),
+ * allocating it at the alignment of T, which C++11 new doesn't honor */
+template <typename T>
+class CacheAligned {
+  public:
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+};
+
+template <typename T>
+void *CacheAligned<T>::operator new(size_t size) {
+    void *p;
+    if (posix_memalign(&p, alignof(T), size) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+template <typename T>
+void CacheAligned<T>::operator delete(void *p) {
+    free(p);
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include <algorithm>
+
+#include "DecimateStage.hpp"
+
+namespace Pipeline {
+
+DecimateStage::DecimateStage(BufferQueue<double> &input, BufferQueue<double> &output, unsigned int channels, unsigned int sampleRate, double bandStart, unsigned int decimation, size_t leadFrames) : Stage("Decimate"), input(input), output(output), channels(channels), bandStart(bandStart), decimation(decimation), inputSampleRate(0), sampleRate(0), leadFrames(leadFrames), chunk(nullptr), sequence(0), position(0), finished(false) {
+    setup(sampleRate);
+}
+
+void DecimateStage::setup(unsigned int sampleRate) {
+    decimators.clear();
+    for (unsigned int c = 0; c < channels; c++)
+        decimators.emplace_back(new DFT::BandDecimator(sampleRate, bandStart, decimation));
+    inputSampleRate = sampleRate;
+    this->sampleRate.store(sampleRate / decimation, std::memory_order_relaxed);
+}
+
+Progress DecimateStage::step() {
+    if (finished)
+        return Progress::Finished;
+
+    if (chunk == nullptr && (chunk = input.pop()) == nullptr)
+        return Progress::Idle;
+
+    Buffer<double> *samples = output.acquire();
+    if (samples == nullptr)
+        return Progress::Idle;
+
+    /* Sample rate switched at the source (this allocates, but seldom) */
+    if (!chunk->data.empty() && chunk->sampleRate != inputSampleRate)
+        setup(chunk->sampleRate);
+
+    /* Decimate each channel, through planar scratch, and interleave the result */
+    size_t frames = chunk->data.size() / channels;
+    size_t decimatedFrames = 0;
+    size_t dropped = 0;
+
+    /* Only allocates if the chunk size grows */
+    channelInput.resize(frames);
+    channelOutput.resize(frames / decimators[0]->getDecimation() + 1);
+    samples->data.resize(channelOutput.size() * channels);
+
+    for (unsigned int c = 0; c < channels; c++) {
+        for (size_t i = 0; i < frames; i++)
+            channelInput[i] = chunk->data[i * channels + c];
+
+        decimatedFrames = decimators[c]->process(channelInput.data(), frames, channelOutput.data());
+
+        /* Drop what is left of the lead in */
+        dropped = std::min(leadFrames, decimatedFrames);
+        for (size_t i = dropped; i < decimatedFrames; i++)
+            samples->data[(i - dropped) * channels + c] = channelOutput[i];
+    }
+    leadFrames -= dropped;
+    decimatedFrames -= dropped;
+    samples->data.resize(decimatedFrames * channels);
+
+    samples->sequence = sequence++;
+    samples->position = position;
+    samples->sampleRate = inputSampleRate / decimation;
+    samples->timestamp = chunk->timestamp;
+    position += decimatedFrames;
+
+    /* An empty chunk forwards the end of the stream */
+    finished = chunk->data.empty();
+
+    input.release(chunk);
+    chunk = nullptr;
+
+    /* Skip pushing chunks that decimated to nothing, unless they mark the end */
+    if (decimatedFrames == 0 && !finished) {
+        output.release(samples);
+        return Progress::Busy;
+    }
+
+    output.push(samples);
+
+    return finished ? Progress::Finished : Progress::Busy;
+}
+
+void DecimateStage::wait(std::chrono::milliseconds rel_time) {
+    if (chunk == nullptr)
+        input.waitReadable(rel_time);
+    else
+        output.waitWritable(rel_time);
+}
+
+unsigned int DecimateStage::getSampleRate() {
+    return sampleRate.load(std::memory_order_relaxed);
+}
+}
@@ -0,0 +1,59 @@
+#ifndef _DECIMATESTAGE_HPP
+#define _DECIMATESTAGE_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+#include "dft/BandDecimator.hpp"
+
+namespace Pipeline {
+
+/* Selects a band of each channel of chunks of interleaved samples, and
+ * decimates it, for the window stage to analyze at the lower rate. Forwards
+ * the empty chunk at the end of the stream. The decimators are set up again
+ * for a chunk at another sample rate. The first decimated frames can be
+ * dropped, the filter's lead in before the start of a range. */
+class DecimateStage : public Stage {
+  public:
+    DecimateStage(BufferQueue<double> &input, BufferQueue<double> &output, unsigned int channels, unsigned int sampleRate, double bandStart, unsigned int decimation, size_t leadFrames = 0);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+    /* Get decimated sample rate in Hz */
+    unsigned int getSampleRate();
+
+  private:
+    /* Set up decimators for an input sample rate */
+    void setup(unsigned int sampleRate);
+
+    BufferQueue<double> &input;
+    BufferQueue<double> &output;
+    const unsigned int channels;
+    const double bandStart;
+    const unsigned int decimation;
+    /* Input sample rate the decimators are set up for, and decimated sample rate */
+    unsigned int inputSampleRate;
+    std::atomic<unsigned int> sampleRate;
+
+    /* Decimator per channel, and planar scratch for a channel in and out */
+    std::vector<std::unique_ptr<DFT::BandDecimator>> decimators;
+    std::vector<double> channelInput;
+    std::vector<double> channelOutput;
+
+    /* Decimated frames left to drop */
+    size_t leadFrames;
+
+    /* Chunk waiting for a free output */
+    Buffer<double> *chunk;
+
+    uint64_t sequence;
+    uint64_t position;
+    bool finished;
+};
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef _EVENTCOUNT_HPP
+#define _EVENTCOUNT_HPP
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+/* Blocking wakeup for lock-free structures. notify() is a fence and an
+ * atomic load unless a thread is actually blocked in waitFor(). */
+class EventCount {
+  public:
+    EventCount() : waiters(0) {}
+
+    /* Wake all waiters, call after publishing a change to the predicate */
+    void notify() {
+        /* Pairs with the fence in waitFor(): either the waiter sees the
+         * published change, or we see its waiters increment and wake it */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lg(lock);
+            cv.notify_all();
+        }
+    }
+
+    /* Block until predicate() is true, returns false on timeout */
+    template <typename Predicate, typename Rep, typename Period>
+    bool waitFor(Predicate predicate, const std::chrono::duration<Rep, Period> &rel_time) {
+        /* Fast path */
+        if (predicate())
+            return true;
+
+        auto deadline = std::chrono::steady_clock::now() + rel_time;
+
+        std::unique_lock<std::mutex> lg(lock);
+        waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool ready;
+        while (!(ready = predicate())) {
+            if (cv.wait_until(lg, deadline) == std::cv_status::timeout) {
+                ready = predicate();
+                break;
+            }
+        }
+
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        return ready;
+    }
+
+  private:
+    std::atomic<unsigned int> waiters;
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "Executor.hpp"
+#include "AllocationCounter.hpp"
+
+namespace Pipeline {
+
+Executor::Executor(bool prefault) : running(false), prefault(prefault), finishedCount(0) {}
+
+Executor::~Executor() {
+    stop();
+}
+
+void Executor::add(Stage &stage, const Realtime::ThreadSettings &threadSettings, bool ownThread) {
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->stage = &stage;
+    entry->threadSettings = threadSettings;
+    entry->ownThread = ownThread;
+    entry->busy = false;
+    entry->finished = false;
+    entries.push_back(std::move(entry));
+}
+
+void Executor::join() {
+    for (auto &thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    std::lock_guard<std::mutex> lg(exceptionLock);
+    if (exception) {
+        std::exception_ptr e = exception;
+        exception = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void Executor::stop() {
+    running = false;
+    for (auto &thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+std::string Executor::getThreadSettings(Stage &stage) {
+    for (auto &entry : entries) {
+        if (entry->stage == &stage)
+            return entry->effectiveThreadSettings;
+    }
+    return "";
+}
+
+size_t Executor::getThreads() {
+    return threads.size();
+}
+
+Progress Executor::step(Entry &entry) {
+    AllocationCounter::track(entry.stage->getAllocations());
+
+    Progress progress = entry.stage->step();
+
+    if (progress == Progress::Finished) {
+        entry.finished = true;
+        /* Last stage to finish stops the executor */
+        if (++finishedCount == entries.size())
+            running = false;
+    }
+
+    return progress;
+}
+
+void Executor::startOwnThreads() {
+    for (auto &entry : entries) {
+        Entry *e = entry.get();
+        if (e->ownThread)
+            e->effectiveThreadSettings = startThread([this, e]() { this->runStage(*e); }, e->threadSettings, e->stage->getName());
+    }
+}
+
+void Executor::runStage(Entry &entry) {
+    AllocationCounter::track(entry.stage->getAllocations());
+
+    while (running) {
+        Progress progress = step(entry);
+        if (progress == Progress::Finished)
+            break;
+
+        /* Wait on the stage's links, with timeout in case this thread is asked to stop */
+        if (progress == Progress::Idle)
+            entry.stage->wait(std::chrono::milliseconds(100));
+    }
+}
+
+SingleThreadExecutor::SingleThreadExecutor(const Realtime::ThreadSettings &threadSettings, bool prefault) : Executor(prefault), threadSettings(threadSettings) {}
+
+void SingleThreadExecutor::start() {
+    running = true;
+
+    startOwnThreads();
+
+    std::string effective = startThread([this]() { this->run(); }, threadSettings, "Pipeline");
+    for (auto &entry : entries) {
+        if (!entry->ownThread)
+            entry->effectiveThreadSettings = effective;
+    }
+}
+
+void SingleThreadExecutor::run() {
+    while (running) {
+        bool progress = false;
+
+        for (auto &entry : entries) {
+            if (!entry->ownThread && !entry->finished && step(*entry) == Progress::Busy)
+                progress = true;
+        }
+
+        /* Every stage is waiting on a link */
+        if (running && !progress)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+ThreadPerStageExecutor::ThreadPerStageExecutor(bool prefault) : Executor(prefault) {}
+
+void ThreadPerStageExecutor::start() {
+    running = true;
+
+    for (auto &entry : entries) {
+        Entry *e = entry.get();
+        entry->effectiveThreadSettings = startThread([this, e]() { this->runStage(*e); }, entry->threadSettings, entry->stage->getName());
+    }
+}
+
+PooledExecutor::PooledExecutor(size_t threadCount, const Realtime::ThreadSettings &threadSettings, bool prefault) : Executor(prefault), threadCount(threadCount), threadSettings(threadSettings) {}
+
+void PooledExecutor::start() {
+    running = true;
+
+    startOwnThreads();
+
+    /* Pool threads share the scheduling, but run on any cpu after the first */
+    Realtime::ThreadSettings poolSettings = threadSettings;
+    std::string effective;
+
+    for (size_t i = 0; i < threadCount; i++) {
+        std::string e = startThread([this, i]() { this->run(i); }, poolSettings, "Pipeline pool");
+        if (i == 0)
+            effective = e;
+        poolSettings.cpu = -1;
+    }
+
+    for (auto &entry : entries) {
+        if (!entry->ownThread)
+            entry->effectiveThreadSettings = effective + " (" + std::to_string(threadCount) + " threads)";
+    }
+}
+
+void PooledExecutor::run(size_t index) {
+    while (running) {
+        bool progress = false;
+
+        /* Start each thread's sweep at a different stage, so they spread out */
+        for (size_t i = 0; i < entries.size(); i++) {
+            Entry &entry = *entries[(index + i) % entries.size()];
+
+            /* Claim the stage, unless another thread is stepping it */
+            bool expected = false;
+            if (entry.ownThread || entry.finished || !entry.busy.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                continue;
+
+            if (!entry.finished && step(entry) == Progress::Busy)
+                progress = true;
+
+            entry.busy.store(false, std::memory_order_release);
+        }
+
+        /* Every unclaimed stage is waiting on a link */
+        if (running && !progress)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+}
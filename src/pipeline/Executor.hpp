@@ -0,0 +1,144 @@
+#ifndef _EXECUTOR_HPP
+#define _EXECUTOR_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <exception>
+
+#include "Stage.hpp"
+#include "Realtime.hpp"
+
+namespace Pipeline {
+
+/* Drives the stages of a pipeline graph on threads. Stages never block on
+ * each other, so any executor can run any graph: each stage is stepped by
+ * one thread at a time, and links carry the data between them. */
+class Executor {
+  public:
+    Executor(bool prefault);
+    virtual ~Executor();
+
+    /* Add a stage, with the scheduling for a thread of its own. With
+     * ownThread, the stage runs on a thread of its own with any executor,
+     * e.g. to read ahead of the stages it feeds. */
+    void add(Stage &stage, const Realtime::ThreadSettings &threadSettings, bool ownThread = false);
+
+    virtual void start() = 0;
+    /* Block until every stage has finished. Rethrows the first exception
+     * thrown by a stage. */
+    void join();
+    /* Stop every stage, finished or not */
+    void stop();
+
+    /* Effective scheduling of the thread running stage */
+    std::string getThreadSettings(Stage &stage);
+    size_t getThreads();
+
+  protected:
+    struct Entry {
+        Stage *stage;
+        Realtime::ThreadSettings threadSettings;
+        std::string effectiveThreadSettings;
+        bool ownThread;
+        /* Claimed by the thread stepping the stage */
+        std::atomic<bool> busy;
+        std::atomic<bool> finished;
+    };
+
+    /* Start a thread running function, configured with threadSettings */
+    template <typename Function>
+    std::string startThread(Function function, const Realtime::ThreadSettings &threadSettings, const std::string &name);
+
+    /* Step a stage, counting its allocations, and note when it finishes */
+    Progress step(Entry &entry);
+
+    /* Start a thread for each stage added with a thread of its own */
+    void startOwnThreads();
+    /* Step a stage on a thread of its own, waiting on its links when it is idle */
+    void runStage(Entry &entry);
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::atomic<bool> running;
+
+  private:
+    /* Run function, stopping every stage if it throws */
+    template <typename Function>
+    void guard(Function function);
+
+    const bool prefault;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> finishedCount;
+
+    std::mutex exceptionLock;
+    std::exception_ptr exception;
+};
+
+/* Sweeps every stage on a single thread, sleeping briefly when none made
+ * progress. No handoffs between threads, best for a single core or small
+ * DFTs. */
+class SingleThreadExecutor : public Executor {
+  public:
+    SingleThreadExecutor(const Realtime::ThreadSettings &threadSettings, bool prefault);
+
+    virtual void start();
+
+  private:
+    void run();
+
+    const Realtime::ThreadSettings threadSettings;
+};
+
+/* Runs every stage on a thread of its own, which waits on the stage's links
+ * when it is idle. */
+class ThreadPerStageExecutor : public Executor {
+  public:
+    ThreadPerStageExecutor(bool prefault);
+
+    virtual void start();
+};
+
+/* Sweeps every stage on a pool of threads, each claiming a stage before
+ * stepping it, sleeping briefly when none made progress. */
+class PooledExecutor : public Executor {
+  public:
+    PooledExecutor(size_t threadCount, const Realtime::ThreadSettings &threadSettings, bool prefault);
+
+    virtual void start();
+
+  private:
+    void run(size_t index);
+
+    const size_t threadCount;
+    const Realtime::ThreadSettings threadSettings;
+};
+
+template <typename Function>
+std::string Executor::startThread(Function function, const Realtime::ThreadSettings &threadSettings, const std::string &name) {
+    threads.emplace_back([this, function]() {
+        this->guard([this, function]() {
+            if (this->prefault)
+                Realtime::prefaultStack();
+            function();
+        });
+    });
+    return Realtime::configureThread(threads.back().native_handle(), threadSettings, name);
+}
+
+template <typename Function>
+void Executor::guard(Function function) {
+    try {
+        function();
+    } catch (...) {
+        std::lock_guard<std::mutex> lg(exceptionLock);
+        if (!exception)
+            exception = std::current_exception();
+        running = false;
+    }
+}
+}
+
+#endif
@@ -0,0 +1,31 @@
+#include "FrameLink.hpp"
+
+namespace Pipeline {
+
+FrameLink::FrameLink(size_t capacity, size_t frameSize) : frames(capacity, frameSize, QueuePolicy::Block), settings(capacity) {}
+
+Buffer<double> *FrameLink::acquire() {
+    return frames.acquire();
+}
+
+void FrameLink::push(Buffer<double> *frame, const FrameSettings &frameSettings) {
+    /* Can't overflow: there are never more frames in flight than settings slots */
+    settings.write(&frameSettings, 1);
+    frames.push(frame);
+}
+
+Buffer<double> *FrameLink::pop(FrameSettings &frameSettings) {
+    Buffer<double> *frame = frames.pop();
+    if (frame != nullptr)
+        settings.read(&frameSettings, 1);
+    return frame;
+}
+
+void FrameLink::release(Buffer<double> *frame) {
+    frames.release(frame);
+}
+
+size_t FrameLink::count() {
+    return frames.count();
+}
+}
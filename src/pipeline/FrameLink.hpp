@@ -0,0 +1,64 @@
+#ifndef _FRAMELINK_HPP
+#define _FRAMELINK_HPP
+
+#include <chrono>
+
+#include "BufferQueue.hpp"
+#include "CacheAligned.hpp"
+#include "SpscRingBuffer.hpp"
+#include "dft/RealDft.hpp"
+#include "spectrogram/SpectrumRenderer.hpp"
+
+namespace Pipeline {
+
+/* Settings a frame is computed and rendered with */
+struct FrameSettings {
+    unsigned int dftSize;
+    DFT::RealDft::WindowFunction dftWf;
+    unsigned int samplesOverlap;
+    Spectrogram::SpectrumRenderer::Settings spectrum;
+    unsigned int pixelStep;
+};
+
+/* Link carrying windowed sample frames, each with the settings it is
+ * computed with. Frames and settings move in lockstep, so this link always
+ * blocks when full rather than dropping. */
+class FrameLink : public CacheAligned<FrameLink> {
+  public:
+    FrameLink(size_t capacity, size_t frameSize);
+
+    /* Producer: acquire a free frame without waiting, nullptr if none */
+    Buffer<double> *acquire();
+    /* Producer: push a filled frame with its settings */
+    void push(Buffer<double> *frame, const FrameSettings &settings);
+    /* Producer: block until a frame is free, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool waitWritable(const std::chrono::duration<Rep, Period> &rel_time);
+
+    /* Consumer: pop a frame and its settings without waiting, nullptr if empty */
+    Buffer<double> *pop(FrameSettings &settings);
+    /* Consumer: release a used frame */
+    void release(Buffer<double> *frame);
+    /* Consumer: block until a frame is queued, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool waitReadable(const std::chrono::duration<Rep, Period> &rel_time);
+
+    size_t count();
+
+  private:
+    BufferQueue<double> frames;
+    SpscRingBuffer<FrameSettings> settings;
+};
+
+template <typename Rep, typename Period>
+bool FrameLink::waitWritable(const std::chrono::duration<Rep, Period> &rel_time) {
+    return frames.waitWritable(rel_time);
+}
+
+template <typename Rep, typename Period>
+bool FrameLink::waitReadable(const std::chrono::duration<Rep, Period> &rel_time) {
+    return frames.waitReadable(rel_time);
+}
+}
+
+#endif
@@ -0,0 +1,50 @@
+#include <algorithm>
+
+#include "GatherStage.hpp"
+
+namespace Pipeline {
+
+GatherStage::GatherStage(const std::vector<BufferQueue<uint32_t> *> &inputs, BufferQueue<uint32_t> &output) : Stage("Gather"), inputs(inputs), output(output), row(nullptr), rowSequence(0), finished(false) {}
+
+Progress GatherStage::step() {
+    if (finished)
+        return Progress::Finished;
+
+    BufferQueue<uint32_t> &input = *inputs[rowSequence % inputs.size()];
+
+    /* Pop the next row in frame order */
+    if (row == nullptr && (row = input.pop()) == nullptr)
+        return Progress::Idle;
+
+    /* Acquire a free output row */
+    Buffer<uint32_t> *pixels = output.acquire();
+    if (pixels == nullptr)
+        return Progress::Idle;
+
+    /* Copy row over, an empty row forwards the end of the stream */
+    pixels->data.resize(row->data.size());
+    std::copy(row->data.begin(), row->data.end(), pixels->data.begin());
+    pixels->sequence = row->sequence;
+    pixels->position = row->position;
+    pixels->span = row->span;
+    pixels->channel = row->channel;
+    pixels->sampleRate = row->sampleRate;
+    pixels->timestamp = row->timestamp;
+    finished = row->data.empty();
+
+    input.release(row);
+    row = nullptr;
+    output.push(pixels);
+
+    rowSequence++;
+
+    return finished ? Progress::Finished : Progress::Busy;
+}
+
+void GatherStage::wait(std::chrono::milliseconds rel_time) {
+    if (row == nullptr)
+        inputs[rowSequence % inputs.size()]->waitReadable(rel_time);
+    else
+        output.waitWritable(rel_time);
+}
+}
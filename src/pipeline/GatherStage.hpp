@@ -0,0 +1,33 @@
+#ifndef _GATHERSTAGE_HPP
+#define _GATHERSTAGE_HPP
+
+#include <vector>
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+
+namespace Pipeline {
+
+/* Puts the rows of transform replicas back in frame order, by popping them
+ * round-robin in the same order the window stage dealt the frames out. */
+class GatherStage : public Stage {
+  public:
+    GatherStage(const std::vector<BufferQueue<uint32_t> *> &inputs, BufferQueue<uint32_t> &output);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+  private:
+    const std::vector<BufferQueue<uint32_t> *> inputs;
+    BufferQueue<uint32_t> &output;
+
+    /* Row waiting for a free output row */
+    Buffer<uint32_t> *row;
+    /* Sequence number of the next row, selects its input */
+    uint64_t rowSequence;
+
+    bool finished;
+};
+}
+
+#endif
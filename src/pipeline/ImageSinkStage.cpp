@@ -0,0 +1,34 @@
+#include "ImageSinkStage.hpp"
+
+namespace Pipeline {
+
+ImageSinkStage::ImageSinkStage(BufferQueue<uint32_t> &input, const std::vector<Image::ImageSink *> &imageSinks) : Stage("Image"), input(input), imageSinks(imageSinks), finished(false) {}
+
+Progress ImageSinkStage::step() {
+    if (finished)
+        return Progress::Finished;
+
+    Buffer<uint32_t> *row = input.pop();
+    if (row == nullptr)
+        return Progress::Idle;
+
+    /* Empty row marks the end of the stream */
+    if (row->data.empty()) {
+        input.release(row);
+        for (Image::ImageSink *imageSink : imageSinks)
+            imageSink->write();
+
+        finished = true;
+        return Progress::Finished;
+    }
+
+    imageSinks[row->channel % imageSinks.size()]->append(row->data);
+    input.release(row);
+
+    return Progress::Busy;
+}
+
+void ImageSinkStage::wait(std::chrono::milliseconds rel_time) {
+    input.waitReadable(rel_time);
+}
+}
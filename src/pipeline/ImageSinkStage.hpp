@@ -0,0 +1,29 @@
+#ifndef _IMAGESINKSTAGE_HPP
+#define _IMAGESINKSTAGE_HPP
+
+#include <vector>
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+#include "image/ImageSink.hpp"
+
+namespace Pipeline {
+
+/* Appends pixel rows to the ImageSink of their channel, and writes the
+ * images out at the end of the stream. */
+class ImageSinkStage : public Stage {
+  public:
+    ImageSinkStage(BufferQueue<uint32_t> &input, const std::vector<Image::ImageSink *> &imageSinks);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+  private:
+    BufferQueue<uint32_t> &input;
+    const std::vector<Image::ImageSink *> imageSinks;
+
+    bool finished;
+};
+}
+
+#endif
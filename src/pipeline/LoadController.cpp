@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "LoadController.hpp"
+
+/* Overloaded above either watermark, headroom below both low watermarks */
+static const double BacklogHighSeconds = 0.100;
+static const double BacklogLowSeconds = 0.020;
+static const double UtilizationHigh = 0.90;
+static const double UtilizationLow = 0.50;
+/* Step up quickly, step down only after a stretch of headroom */
+static const std::chrono::milliseconds StepUpInterval(100);
+static const std::chrono::milliseconds StepDownInterval(1000);
+
+/* Overlap is lowered towards the bound in this many levels */
+static const unsigned int OverlapLevels = 4;
+
+static unsigned int log2Floor(unsigned int n) {
+    unsigned int l = 0;
+    while (n > 1) {
+        n >>= 1;
+        l++;
+    }
+    return l;
+}
+
+LoadController::LoadController(const Bounds &bounds) : bounds(bounds), overlapLevels(OverlapLevels), skipLevels(bounds.skipMax > 1 ? bounds.skipMax - 1 : 0), pixelStepLevels(log2Floor(bounds.pixelStepMax)), lastChange(std::chrono::steady_clock::now()), lastOverload(lastChange), level(0), utilization(0), backlogMilliseconds(0), degradedOverlap(0), degradedSkip(1), degradedPixelStep(1) {}
+
+void LoadController::update(size_t backlogSamples, double frameSeconds, size_t hopSamples, size_t threads, unsigned int sampleRate) {
+    double backlogSeconds = static_cast<double>(backlogSamples) / static_cast<double>(sampleRate);
+    double hopSeconds = static_cast<double>(hopSamples) / static_cast<double>(sampleRate);
+    /* Only one in skip frames is computed */
+    double load = (frameSeconds / static_cast<double>(degradedSkip)) / (hopSeconds * static_cast<double>(threads));
+
+    backlogMilliseconds = static_cast<unsigned int>(backlogSeconds * 1000.0);
+    utilization = static_cast<unsigned int>(load * 100.0);
+
+    if (!bounds.enabled)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    bool overloaded = backlogSeconds > BacklogHighSeconds || load > UtilizationHigh;
+    bool headroom = backlogSeconds < BacklogLowSeconds && load < UtilizationLow;
+
+    if (overloaded)
+        lastOverload = now;
+
+    if (overloaded && level < getLevels() && now - lastChange >= StepUpInterval) {
+        level++;
+        lastChange = now;
+    } else if (headroom && level > 0 && now - lastChange >= StepDownInterval && now - lastOverload >= StepDownInterval) {
+        level--;
+        lastChange = now;
+    }
+}
+
+LoadController::Degradation LoadController::degrade(unsigned int dftSize, unsigned int samplesOverlap) {
+    unsigned int l = level;
+    Degradation degradation;
+
+    /* Lower overlap towards the bound */
+    unsigned int overlapLevel = std::min(l, overlapLevels);
+    unsigned int overlapMin = static_cast<unsigned int>(bounds.samplesOverlapMin * static_cast<float>(dftSize));
+    if (samplesOverlap > overlapMin)
+        samplesOverlap -= (samplesOverlap - overlapMin) * overlapLevel / overlapLevels;
+    degradation.samplesOverlap = samplesOverlap;
+    l -= overlapLevel;
+
+    /* Then skip frames */
+    unsigned int skipLevel = std::min(l, skipLevels);
+    degradation.skip = 1 + skipLevel;
+    l -= skipLevel;
+
+    /* Then coarser pixel rows */
+    degradation.pixelStep = 1u << std::min(l, pixelStepLevels);
+
+    degradedOverlap = degradation.samplesOverlap;
+    degradedSkip = degradation.skip;
+    degradedPixelStep = degradation.pixelStep;
+
+    return degradation;
+}
+
+unsigned int LoadController::getLevel() {
+    return level;
+}
+
+unsigned int LoadController::getLevels() {
+    return overlapLevels + skipLevels + pixelStepLevels;
+}
+
+unsigned int LoadController::getUtilization() {
+    return utilization;
+}
+
+unsigned int LoadController::getBacklogMilliseconds() {
+    return backlogMilliseconds;
+}
+
+LoadController::Degradation LoadController::getDegradation() {
+    return {degradedOverlap, degradedSkip, degradedPixelStep};
+}
@@ -0,0 +1,70 @@
+#ifndef _LOADCONTROLLER_HPP
+#define _LOADCONTROLLER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+/* Feedback controller that sheds spectrogram work when the pipeline falls
+ * behind. It watches the samples backlog and the DFT utilization (frame
+ * compute time over the time a hop of audio lasts), and steps through
+ * degradation levels within operator bounds: first lower overlap, then skip
+ * frames, then coarser pixel rows. Levels step back down once there is
+ * headroom again. */
+class LoadController {
+  public:
+    struct Bounds {
+        bool enabled;
+        /* Lowest overlap shedding may drop to (0.00 - 1.00) */
+        float samplesOverlapMin;
+        /* Compute at most one in skipMax frames */
+        unsigned int skipMax;
+        /* Coarsest pixel step, power of two */
+        unsigned int pixelStepMax;
+    };
+
+    /* Degradation of a frame at the current level */
+    struct Degradation {
+        unsigned int samplesOverlap;
+        unsigned int skip;
+        unsigned int pixelStep;
+    };
+
+    LoadController(const Bounds &bounds);
+
+    /* Feed measurements, once per hop: samples waiting in the samples queue,
+     * average frame compute time, frame threads sharing the work, and the
+     * sample rate the samples are at */
+    void update(size_t backlogSamples, double frameSeconds, size_t hopSamples, size_t threads, unsigned int sampleRate);
+
+    /* Degrade requested overlap for dftSize at the current level */
+    Degradation degrade(unsigned int dftSize, unsigned int samplesOverlap);
+
+    /* Statistics */
+    unsigned int getLevel();
+    unsigned int getLevels();
+    unsigned int getUtilization();
+    unsigned int getBacklogMilliseconds();
+    Degradation getDegradation();
+
+  private:
+    const Bounds bounds;
+
+    /* Levels of each kind of degradation, in the order they are applied */
+    const unsigned int overlapLevels;
+    const unsigned int skipLevels;
+    const unsigned int pixelStepLevels;
+
+    std::chrono::steady_clock::time_point lastChange;
+    std::chrono::steady_clock::time_point lastOverload;
+
+    /* Read by the interface for statistics */
+    std::atomic<unsigned int> level;
+    std::atomic<unsigned int> utilization;
+    std::atomic<unsigned int> backlogMilliseconds;
+    std::atomic<unsigned int> degradedOverlap;
+    std::atomic<unsigned int> degradedSkip;
+    std::atomic<unsigned int> degradedPixelStep;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#include <sched.h>
+#include <alloca.h>
+#include <sys/mman.h>
+
+#include "Realtime.hpp"
+
+namespace Realtime {
+
+std::string to_string(const Scheduler &scheduler) {
+    if (scheduler == Scheduler::Other)
+        return "SCHED_OTHER";
+    else if (scheduler == Scheduler::Fifo)
+        return "SCHED_FIFO";
+    else if (scheduler == Scheduler::RoundRobin)
+        return "SCHED_RR";
+
+    return "";
+}
+
+std::string configureThread(pthread_t thread, const ThreadSettings &settings, const std::string &name) {
+    std::string effective;
+    int ret;
+
+    /* CPU affinity */
+    if (settings.cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+
+        if (settings.cpu >= CPU_SETSIZE) {
+            ret = EINVAL;
+        } else {
+            CPU_SET(settings.cpu, &cpuset);
+            ret = pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset);
+        }
+
+        if (ret == 0) {
+            effective = "cpu " + std::to_string(settings.cpu);
+        } else {
+            std::cerr << "Warning: " << name << " thread: pinning to cpu " << settings.cpu << ": " << strerror(ret) << ", running on any cpu.\n";
+            effective = "any cpu";
+        }
+    } else {
+        effective = "any cpu";
+    }
+
+    /* Scheduling policy and priority */
+    if (settings.scheduler != Scheduler::Other) {
+        int policy = (settings.scheduler == Scheduler::Fifo) ? SCHED_FIFO : SCHED_RR;
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = settings.priority;
+
+        ret = pthread_setschedparam(thread, policy, &param);
+        if (ret == 0) {
+            effective += ", " + to_string(settings.scheduler) + " " + std::to_string(settings.priority);
+        } else {
+            std::cerr << "Warning: " << name << " thread: " << to_string(settings.scheduler) << " priority " << settings.priority << ": " << strerror(ret) << ", using SCHED_OTHER.\n";
+            effective += ", SCHED_OTHER (" + to_string(settings.scheduler) + " denied)";
+        }
+    } else {
+        effective += ", SCHED_OTHER";
+    }
+
+    return effective;
+}
+
+std::string lockMemory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        std::cerr << "Warning: locking memory: mlockall(): " << strerror(errno) << ", memory may be paged.\n";
+        return "unlocked (denied)";
+    }
+
+    return "locked";
+}
+
+void prefaultStack(size_t size) {
+    /* volatile, so the writes aren't optimized out */
+    volatile unsigned char *stack = static_cast<volatile unsigned char *>(alloca(size));
+    for (size_t i = 0; i < size; i += 4096)
+        stack[i] = 0;
+}
+}
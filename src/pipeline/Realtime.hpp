@@ -0,0 +1,35 @@
+#ifndef _REALTIME_HPP
+#define _REALTIME_HPP
+
+#include <string>
+#include <cstddef>
+
+#include <pthread.h>
+
+namespace Realtime {
+
+enum class Scheduler { Other,
+                       Fifo,
+                       RoundRobin };
+
+struct ThreadSettings {
+    /* CPU to pin to, -1 for any */
+    int cpu = -1;
+    Scheduler scheduler = Scheduler::Other;
+    int priority = 0;
+};
+
+/* Apply CPU affinity and scheduling to a thread. Whatever isn't permitted
+ * is left at the default with a warning. Returns the effective settings. */
+std::string configureThread(pthread_t thread, const ThreadSettings &settings, const std::string &name);
+
+/* Lock current and future memory, returns the effective state */
+std::string lockMemory();
+
+/* Touch size bytes of the calling thread's stack, so it is faulted in up front */
+void prefaultStack(size_t size = 256 * 1024);
+
+std::string to_string(const Scheduler &scheduler);
+}
+
+#endif
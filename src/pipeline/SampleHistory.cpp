@@ -0,0 +1,90 @@
+#include <algorithm>
+
+#include "SampleHistory.hpp"
+
+namespace Pipeline {
+
+/* Frames per block: small enough to copy without holding up the writer, large
+ * enough that the writer takes a lock every few reads */
+static const size_t BlockFrames = 4096;
+
+/* One block more than asked, as the oldest block is overwritten a block at a time */
+SampleHistory::SampleHistory(size_t frames, unsigned int channels) : channels(channels), blockFrames(BlockFrames), blockCount((frames + BlockFrames - 1) / BlockFrames + 1), ring(blockCount * BlockFrames * channels, 0.0), blocks(new Block[blockCount]), end(0) {
+    for (size_t b = 0; b < blockCount; b++)
+        blocks[b].position = ~static_cast<uint64_t>(0);
+}
+
+void SampleHistory::write(const double *samples, uint64_t position, size_t frames) {
+    while (frames > 0) {
+        uint64_t blockPosition = position - position % blockFrames;
+        size_t offset = static_cast<size_t>(position - blockPosition);
+        size_t count = std::min(frames, blockFrames - offset);
+        size_t b = static_cast<size_t>((blockPosition / blockFrames) % blockCount);
+        double *blockSamples = ring.data() + b * blockFrames * channels;
+
+        {
+            std::lock_guard<std::mutex> lg(blocks[b].lock);
+
+            /* Starting the block over, clear what it held before */
+            if (blocks[b].position != blockPosition) {
+                std::fill(blockSamples, blockSamples + blockFrames * channels, 0.0);
+                blocks[b].position = blockPosition;
+            }
+
+            std::copy(samples, samples + count * channels, blockSamples + offset * channels);
+        }
+
+        samples += count * channels;
+        position += count;
+        frames -= count;
+    }
+
+    if (position > end.load(std::memory_order_relaxed))
+        end.store(position, std::memory_order_release);
+}
+
+size_t SampleHistory::read(double *samples, uint64_t position, size_t frames) {
+    uint64_t written = end.load(std::memory_order_acquire);
+    size_t held = 0;
+
+    while (frames > 0) {
+        uint64_t blockPosition = position - position % blockFrames;
+        size_t offset = static_cast<size_t>(position - blockPosition);
+        size_t count = std::min(frames, blockFrames - offset);
+        size_t b = static_cast<size_t>((blockPosition / blockFrames) % blockCount);
+        const double *blockSamples = ring.data() + b * blockFrames * channels;
+
+        {
+            std::lock_guard<std::mutex> lg(blocks[b].lock);
+
+            /* The block holds this lap, up to what was written when we started */
+            size_t valid = (blocks[b].position == blockPosition && written > position) ? static_cast<size_t>(std::min<uint64_t>(count, written - position)) : 0;
+
+            std::copy(blockSamples + offset * channels, blockSamples + (offset + valid) * channels, samples);
+            std::fill(samples + valid * channels, samples + count * channels, 0.0);
+            held += valid;
+        }
+
+        samples += count * channels;
+        position += count;
+        frames -= count;
+    }
+
+    return held;
+}
+
+uint64_t SampleHistory::getBegin() {
+    uint64_t written = end.load(std::memory_order_acquire);
+    uint64_t capacity = static_cast<uint64_t>(blockCount - 1) * blockFrames;
+    /* The oldest block may be partly overwritten already, so count only whole blocks behind the newest */
+    return (written > capacity) ? written - capacity : 0;
+}
+
+uint64_t SampleHistory::getEnd() {
+    return end.load(std::memory_order_acquire);
+}
+
+unsigned int SampleHistory::getChannels() {
+    return channels;
+}
+}
@@ -0,0 +1,53 @@
+#ifndef _SAMPLEHISTORY_HPP
+#define _SAMPLEHISTORY_HPP
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace Pipeline {
+
+/* Ring of the last frames of interleaved samples of a stream, by stream
+ * position, for a region to be read back while the stream carries on. The
+ * ring is divided into blocks, each locked while it is written or read, so
+ * the writer only ever waits on a reader copying the one block it is about
+ * to overwrite. */
+class SampleHistory {
+  public:
+    /* Holds at least frames frames of channels interleaved channels */
+    SampleHistory(size_t frames, unsigned int channels);
+
+    /* Writer: record frames at their stream position. Positions skipped,
+     * e.g. by dropped samples, read back as silence. */
+    void write(const double *samples, uint64_t position, size_t frames);
+
+    /* Reader: copy frames from position, silence for frames not held (not
+     * written yet, or overwritten). Returns the number of frames held. */
+    size_t read(double *samples, uint64_t position, size_t frames);
+
+    /* Stream positions held, from the oldest to past the newest */
+    uint64_t getBegin();
+    uint64_t getEnd();
+
+    unsigned int getChannels();
+
+  private:
+    struct Block {
+        std::mutex lock;
+        /* Stream position of the block's first frame, ~0 if never written */
+        uint64_t position;
+    };
+
+    const unsigned int channels;
+    const size_t blockFrames;
+    const size_t blockCount;
+    std::vector<double> ring;
+    std::unique_ptr<Block[]> blocks;
+    /* Past the newest position written */
+    std::atomic<uint64_t> end;
+};
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef _SNAPSHOT_HPP
+#define _SNAPSHOT_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+/* Versioned settings snapshot with a single reader. Writers publish
+ * immutable copies with an atomic pointer swap. The reader picks up the
+ * latest copy with acquire() and acknowledges its version, which lets
+ * writers reclaim older copies later without ever blocking the reader. */
+template <typename T>
+class Snapshot {
+  public:
+    Snapshot(const T &initial);
+    ~Snapshot();
+
+    /* Writer: get a copy of the latest value */
+    T get();
+    /* Writer: publish a copy of the latest value modified by modify(T &) */
+    template <typename Modify>
+    void update(Modify modify);
+
+    /* Reader: get the latest value, valid until the next call to acquire() */
+    const T &acquire();
+
+    /* Statistics */
+    uint64_t getVersion();
+    size_t getWriterContention();
+    size_t getRetiredCount();
+
+  private:
+    struct Node {
+        T value;
+        uint64_t version;
+    };
+
+    void reclaim();
+
+    std::atomic<Node *> current;
+    /* Version of the node last acquired by the reader */
+    std::atomic<uint64_t> readerVersion;
+
+    /* Serializes writers only, the reader never takes it */
+    std::mutex writerLock;
+    std::atomic<size_t> writerContention;
+    std::vector<Node *> retired;
+};
+
+template <typename T>
+Snapshot<T>::Snapshot(const T &initial) : current(new Node{initial, 1}), readerVersion(0), writerContention(0) {}
+
+template <typename T>
+Snapshot<T>::~Snapshot() {
+    for (Node *node : retired)
+        delete node;
+    delete current.load();
+}
+
+template <typename T>
+T Snapshot<T>::get() {
+    std::lock_guard<std::mutex> lg(writerLock);
+    return current.load(std::memory_order_relaxed)->value;
+}
+
+template <typename T>
+template <typename Modify>
+void Snapshot<T>::update(Modify modify) {
+    std::unique_lock<std::mutex> lg(writerLock, std::try_to_lock);
+    if (!lg.owns_lock()) {
+        writerContention++;
+        lg.lock();
+    }
+
+    Node *old = current.load(std::memory_order_relaxed);
+    Node *node = new Node{old->value, old->version + 1};
+    modify(node->value);
+
+    current.store(node, std::memory_order_release);
+    retired.push_back(old);
+
+    reclaim();
+}
+
+template <typename T>
+const T &Snapshot<T>::acquire() {
+    Node *node = current.load(std::memory_order_acquire);
+    readerVersion.store(node->version, std::memory_order_release);
+    return node->value;
+}
+
+template <typename T>
+void Snapshot<T>::reclaim() {
+    /* Any node older than the one the reader last acquired is unreachable:
+     * the reader only ever moves on to the current node, whose version is
+     * at least readerVersion */
+    uint64_t version = readerVersion.load(std::memory_order_acquire);
+
+    auto it = retired.begin();
+    while (it != retired.end()) {
+        if ((*it)->version < version) {
+            delete *it;
+            it = retired.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+template <typename T>
+uint64_t Snapshot<T>::getVersion() {
+    std::lock_guard<std::mutex> lg(writerLock);
+    return current.load(std::memory_order_relaxed)->version;
+}
+
+template <typename T>
+size_t Snapshot<T>::getWriterContention() {
+    return writerContention;
+}
+
+template <typename T>
+size_t Snapshot<T>::getRetiredCount() {
+    std::lock_guard<std::mutex> lg(writerLock);
+    return retired.size();
+}
+
+#endif
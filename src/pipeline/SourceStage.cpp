@@ -0,0 +1,73 @@
+#include "SourceStage.hpp"
+
+namespace Pipeline {
+
+SourceStage::SourceStage(Audio::AudioSource &audioSource, BufferQueue<double> &output, size_t readSize, uint64_t start, uint64_t length) : Stage("Audio"), audioSource(audioSource), output(output), readSize(readSize), start(start), remaining(length), bounded(length > 0), sampleRate(audioSource.getSampleRate()), channels(audioSource.getChannels()), sequence(0), position(0), finished(false) {}
+
+Progress SourceStage::step() {
+    if (finished)
+        return Progress::Finished;
+
+    Buffer<double> *samples = output.acquire();
+    if (samples == nullptr)
+        return Progress::Idle;
+
+    /* Only allocates if the read size grows */
+    samples->data.resize(readSize * channels);
+    if (start > 0)
+        seek(samples->data.data());
+
+    size_t count = readSize;
+    if (bounded)
+        count = static_cast<size_t>(std::min<uint64_t>(count, remaining));
+    count = (count > 0) ? audioSource.read(samples->data.data(), count) : 0;
+    samples->data.resize(count * channels);
+    remaining -= bounded ? count : 0;
+
+    /* A switch of sample rate takes effect at a read */
+    unsigned int rate = audioSource.getSampleRate();
+    sampleRate.store(rate, std::memory_order_relaxed);
+
+    samples->sequence = sequence++;
+    samples->position = position;
+    samples->sampleRate = rate;
+    samples->timestamp = audioSource.getReadTimestamp();
+    if (count > 0 && samples->timestamp != std::chrono::steady_clock::time_point())
+        samples->timestamp += sampleDuration(count - 1, rate);
+    position += count;
+
+    /* Empty chunk marks the end of the source */
+    output.push(samples);
+    if (count == 0) {
+        finished = true;
+        return Progress::Finished;
+    }
+
+    return Progress::Busy;
+}
+
+void SourceStage::seek(double *scratch) {
+    if (!audioSource.seek(start)) {
+        while (start > 0) {
+            size_t count = audioSource.read(scratch, static_cast<size_t>(std::min<uint64_t>(start, readSize)));
+            if (count == 0)
+                break;
+            start -= count;
+        }
+    }
+
+    start = 0;
+}
+
+void SourceStage::wait(std::chrono::milliseconds rel_time) {
+    output.waitWritable(rel_time);
+}
+
+unsigned int SourceStage::getSampleRate() {
+    return sampleRate.load(std::memory_order_relaxed);
+}
+
+unsigned int SourceStage::getChannels() {
+    return channels;
+}
+}
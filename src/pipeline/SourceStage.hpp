@@ -0,0 +1,53 @@
+#ifndef _SOURCESTAGE_HPP
+#define _SOURCESTAGE_HPP
+
+#include <atomic>
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+#include "audio/AudioSource.hpp"
+
+namespace Pipeline {
+
+/* Reads chunks of interleaved samples from an AudioSource into the samples
+ * link. Pushes an empty chunk at the end of the source. A range of the
+ * source can be read, starting with a seek, or by skipping frames if the
+ * source can't seek. Each chunk carries the sample rate it was read at, a
+ * source may switch sample rates between reads. */
+class SourceStage : public Stage {
+  public:
+    /* Read size, start and length (0 for the rest of the source) in frames */
+    SourceStage(Audio::AudioSource &audioSource, BufferQueue<double> &output, size_t readSize, uint64_t start = 0, uint64_t length = 0);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+    /* Get AudioSource sample rate in Hz */
+    unsigned int getSampleRate();
+    /* Get AudioSource channels */
+    unsigned int getChannels();
+
+  private:
+    /* Seek to the start of the range, or read up to it */
+    void seek(double *scratch);
+
+    Audio::AudioSource &audioSource;
+    BufferQueue<double> &output;
+    const size_t readSize;
+
+    /* Frames to skip to the start, and left in the range */
+    uint64_t start;
+    uint64_t remaining;
+    const bool bounded;
+
+    /* Sample rate of the last read, and channels, read once */
+    std::atomic<unsigned int> sampleRate;
+    const unsigned int channels;
+
+    uint64_t sequence;
+    uint64_t position;
+    bool finished;
+};
+}
+
+#endif
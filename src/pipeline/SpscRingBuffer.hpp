@@ -0,0 +1,146 @@
+#ifndef _SPSCRINGBUFFER_HPP
+#define _SPSCRINGBUFFER_HPP
+
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+#include "EventCount.hpp"
+
+/* Bounded lock-free single-producer/single-consumer ring buffer. Reads and
+ * writes never take a lock; the event count only locks when a thread is
+ * actually blocked in waitReadable() or waitWritable(). */
+template <typename T>
+class SpscRingBuffer {
+  public:
+    SpscRingBuffer(size_t capacity);
+
+    /* Producer: write all count elements, or nothing if there is not enough space */
+    bool write(const T *data, size_t count);
+    /* Consumer: read up to count elements, returns number of elements read */
+    size_t read(T *data, size_t count);
+    /* Consumer: discard up to count elements, returns number of elements discarded */
+    size_t discard(size_t count);
+
+    size_t count();
+    size_t space();
+    size_t capacity();
+    bool empty();
+
+    /* Block until count elements are readable, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool waitReadable(size_t count, const std::chrono::duration<Rep, Period> &rel_time);
+    /* Block until count elements are writable, returns false on timeout */
+    template <typename Rep, typename Period>
+    bool waitWritable(size_t count, const std::chrono::duration<Rep, Period> &rel_time);
+
+  private:
+    const size_t mask;
+    std::unique_ptr<T[]> buffer;
+
+    /* Free-running indices, each on its own cache line */
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+    /* Blocking wakeup for both sides */
+    alignas(64) EventCount event;
+};
+
+static inline size_t roundUpPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+template <typename T>
+SpscRingBuffer<T>::SpscRingBuffer(size_t capacity) : mask(roundUpPowerOfTwo(capacity) - 1), buffer(new T[mask + 1]), head(0), tail(0) {}
+
+template <typename T>
+size_t SpscRingBuffer<T>::count() {
+    /* Load tail first, so head can only be ahead of it */
+    size_t t = tail.load(std::memory_order_acquire);
+    return head.load(std::memory_order_acquire) - t;
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::space() {
+    return capacity() - count();
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::capacity() {
+    return mask + 1;
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::empty() {
+    return count() == 0;
+}
+
+template <typename T>
+bool SpscRingBuffer<T>::write(const T *data, size_t count) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+
+    if (capacity() - (h - t) < count)
+        return false;
+
+    /* Copy in up to two contiguous pieces */
+    size_t offset = h & mask;
+    size_t first = std::min(count, capacity() - offset);
+    std::copy(data, data + first, buffer.get() + offset);
+    std::copy(data + first, data + count, buffer.get());
+
+    head.store(h + count, std::memory_order_release);
+    event.notify();
+
+    return true;
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::read(T *data, size_t count) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+
+    count = std::min(count, h - t);
+
+    /* Copy out up to two contiguous pieces */
+    size_t offset = t & mask;
+    size_t first = std::min(count, capacity() - offset);
+    std::copy(buffer.get() + offset, buffer.get() + offset + first, data);
+    std::copy(buffer.get(), buffer.get() + (count - first), data + first);
+
+    tail.store(t + count, std::memory_order_release);
+    event.notify();
+
+    return count;
+}
+
+template <typename T>
+size_t SpscRingBuffer<T>::discard(size_t count) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+
+    count = std::min(count, h - t);
+
+    tail.store(t + count, std::memory_order_release);
+    event.notify();
+
+    return count;
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool SpscRingBuffer<T>::waitReadable(size_t count, const std::chrono::duration<Rep, Period> &rel_time) {
+    return event.waitFor([this, count]() { return this->count() >= count; }, rel_time);
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool SpscRingBuffer<T>::waitWritable(size_t count, const std::chrono::duration<Rep, Period> &rel_time) {
+    return event.waitFor([this, count]() { return this->space() >= count; }, rel_time);
+}
+
+#endif
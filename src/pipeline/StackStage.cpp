@@ -0,0 +1,63 @@
+#include <algorithm>
+
+#include "StackStage.hpp"
+
+namespace Pipeline {
+
+StackStage::StackStage(BufferQueue<uint32_t> &input, BufferQueue<uint32_t> &output, unsigned int channels, size_t width) : Stage("Stack"), input(input), output(output), channels(channels), width(width), laneWidth(width / channels), stacked(nullptr), stackedChannels(0), finished(false) {}
+
+Progress StackStage::step() {
+    if (finished)
+        return Progress::Finished;
+
+    /* Acquire a free output row */
+    if (stacked == nullptr && (stacked = output.acquire()) == nullptr)
+        return Progress::Idle;
+
+    Buffer<uint32_t> *row = input.pop();
+    if (row == nullptr)
+        return Progress::Idle;
+
+    /* Empty row marks the end of the stream, forward it */
+    if (row->data.empty()) {
+        input.release(row);
+
+        stacked->data.resize(0);
+        output.push(stacked);
+        stacked = nullptr;
+
+        finished = true;
+        return Progress::Finished;
+    }
+
+    /* Copy row into its channel's slot, the first channel sets the metadata */
+    size_t count = std::min(row->data.size(), laneWidth);
+    stacked->data.resize(width);
+    std::copy(row->data.begin(), row->data.begin() + static_cast<std::ptrdiff_t>(count), stacked->data.begin() + static_cast<std::ptrdiff_t>(laneWidth * stackedChannels));
+    if (stackedChannels == 0) {
+        stacked->sequence = row->sequence / channels;
+        stacked->position = row->position;
+        stacked->span = row->span;
+        stacked->sampleRate = row->sampleRate;
+        stacked->timestamp = row->timestamp;
+        stacked->channel = 0;
+    }
+    input.release(row);
+
+    if (++stackedChannels == channels) {
+        std::fill(stacked->data.begin() + static_cast<std::ptrdiff_t>(laneWidth * channels), stacked->data.end(), 0);
+        output.push(stacked);
+        stacked = nullptr;
+        stackedChannels = 0;
+    }
+
+    return Progress::Busy;
+}
+
+void StackStage::wait(std::chrono::milliseconds rel_time) {
+    if (stacked == nullptr)
+        output.waitWritable(rel_time);
+    else
+        input.waitReadable(rel_time);
+}
+}
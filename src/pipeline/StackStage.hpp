@@ -0,0 +1,35 @@
+#ifndef _STACKSTAGE_HPP
+#define _STACKSTAGE_HPP
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+
+namespace Pipeline {
+
+/* Stacks the rows of each channel side by side into one row of the output
+ * width, from rows that arrive in frame order, one per channel. Pixels left
+ * over past the last channel are black. */
+class StackStage : public Stage {
+  public:
+    StackStage(BufferQueue<uint32_t> &input, BufferQueue<uint32_t> &output, unsigned int channels, size_t width);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+  private:
+    BufferQueue<uint32_t> &input;
+    BufferQueue<uint32_t> &output;
+    const unsigned int channels;
+    /* Output row width, and width of each channel's slot in it */
+    const size_t width;
+    const size_t laneWidth;
+
+    /* Row being stacked, and channels stacked so far */
+    Buffer<uint32_t> *stacked;
+    unsigned int stackedChannels;
+
+    bool finished;
+};
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _STAGE_HPP
+#define _STAGE_HPP
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+
+namespace Pipeline {
+
+/* Duration of count samples at sampleRate */
+static inline std::chrono::steady_clock::duration sampleDuration(uint64_t count, unsigned int sampleRate) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(count) / static_cast<double>(sampleRate)));
+}
+
+enum class Progress { Busy,
+                      Idle,
+                      Finished };
+
+/* A stage of the pipeline graph. Stages are connected by bounded links
+ * (BufferQueues) and driven by an executor, which calls step() from one
+ * thread at a time. */
+class Stage {
+  public:
+    Stage(const std::string &name) : name(name), allocations(0) {}
+    virtual ~Stage() {}
+
+    /* Do a bounded amount of work. Returns Busy if progress was made, Idle if
+     * waiting on a link, Finished once the end of the stream has passed.
+     * Only sources reading from a device block in step(). */
+    virtual Progress step() = 0;
+
+    /* Block until step() may make progress, or rel_time passes */
+    virtual void wait(std::chrono::milliseconds rel_time) {
+        std::this_thread::sleep_for(std::min(rel_time, std::chrono::milliseconds(1)));
+    }
+
+    std::string getName() {
+        return name;
+    }
+
+    /* Heap allocations made in step(), counted by the executor */
+    std::atomic<size_t> &getAllocations() {
+        return allocations;
+    }
+
+  private:
+    const std::string name;
+    std::atomic<size_t> allocations;
+};
+}
+
+#endif
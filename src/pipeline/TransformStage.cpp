@@ -0,0 +1,85 @@
+#include "TransformStage.hpp"
+
+namespace Pipeline {
+
+TransformStage::TransformStage(FrameLink *input, BufferQueue<uint32_t> &output, const FrameSettings &initialSettings, size_t pixelsWidth) : Stage("Transform"), input(input), output(output), pixelsWidth(pixelsWidth), realDft(initialSettings.dftSize, initialSettings.dftWf), spectrumRenderer(initialSettings.spectrum.magnitudeMin, initialSettings.spectrum.magnitudeMax, initialSettings.spectrum.magnitudeLog, initialSettings.spectrum.colors), dftSamples(initialSettings.dftSize / 2 + 1), frameSeconds(0.0), frame(nullptr), frameSettings(initialSettings), finished(false) {}
+
+Progress TransformStage::step() {
+    if (finished || input == nullptr)
+        return Progress::Finished;
+
+    /* Pop the next frame and its settings */
+    if (frame == nullptr && (frame = input->pop(frameSettings)) == nullptr)
+        return Progress::Idle;
+
+    /* Acquire a free row */
+    Buffer<uint32_t> *row = output.acquire();
+    if (row == nullptr)
+        return Progress::Idle;
+
+    row->sequence = frame->sequence;
+    row->position = frame->position;
+    row->span = frame->span;
+    row->channel = frame->channel;
+    row->sampleRate = frame->sampleRate;
+    row->timestamp = frame->timestamp;
+
+    /* Empty frame marks the end of the stream, forward it */
+    render(frame->data.empty() ? nullptr : frame->data.data(), frameSettings, row);
+
+    input->release(frame);
+    frame = nullptr;
+
+    return finished ? Progress::Finished : Progress::Busy;
+}
+
+Buffer<uint32_t> *TransformStage::acquireRow() {
+    return output.acquire();
+}
+
+void TransformStage::render(const double *samples, const FrameSettings &settings, Buffer<uint32_t> *row) {
+    if (samples == nullptr) {
+        row->data.resize(0);
+        output.push(row);
+
+        finished = true;
+        return;
+    }
+
+    /* Resize DFT if N changed (replans on this thread, nobody waits on it) */
+    if (settings.dftSize != realDft.getSize()) {
+        realDft.setSize(settings.dftSize);
+        dftSamples.resize(settings.dftSize / 2 + 1);
+    }
+    if (settings.dftWf != realDft.getWindowFunction())
+        realDft.setWindowFunction(settings.dftWf);
+
+    spectrumRenderer.settings = settings.spectrum;
+
+    auto tic = std::chrono::steady_clock::now();
+
+    /* Compute DFT */
+    realDft.compute(dftSamples, samples);
+
+    /* Render spectrogram line */
+    row->data.resize(pixelsWidth);
+    spectrumRenderer.render(row->data, dftSamples, settings.pixelStep);
+
+    /* Track frame compute time for load shedding */
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - tic;
+    frameSeconds = 0.9 * frameSeconds + 0.1 * elapsed.count();
+
+    output.push(row);
+}
+
+void TransformStage::wait(std::chrono::milliseconds rel_time) {
+    if (input != nullptr && frame == nullptr)
+        input->waitReadable(rel_time);
+    else
+        output.waitWritable(rel_time);
+}
+
+double TransformStage::getFrameSeconds() {
+    return frameSeconds;
+}
+}
@@ -0,0 +1,58 @@
+#ifndef _TRANSFORMSTAGE_HPP
+#define _TRANSFORMSTAGE_HPP
+
+#include <vector>
+#include <complex>
+#include <atomic>
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+#include "FrameLink.hpp"
+#include "dft/RealDft.hpp"
+#include "spectrogram/SpectrumRenderer.hpp"
+
+namespace Pipeline {
+
+/* Computes the DFT of each frame, reduces it to magnitudes and renders a
+ * pixel row, with the settings the frame was windowed with. Several can run
+ * side by side on frames dealt out round-robin. Forwards an empty row at the
+ * end of the stream. Without an input link, a lone transform is run by the
+ * window stage on its own step instead, straight from the window. */
+class TransformStage : public Stage {
+  public:
+    TransformStage(FrameLink *input, BufferQueue<uint32_t> &output, const FrameSettings &initialSettings, size_t pixelsWidth);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+    /* Acquire a free row without waiting, nullptr if none */
+    Buffer<uint32_t> *acquireRow();
+    /* Render samples (dftSize of them, nullptr at the end of the stream)
+     * into the row, and push it */
+    void render(const double *samples, const FrameSettings &settings, Buffer<uint32_t> *row);
+
+    /* Average frame compute time in seconds */
+    double getFrameSeconds();
+
+  private:
+    /* Frames to transform, nullptr if run by the window stage */
+    FrameLink *input;
+    BufferQueue<uint32_t> &output;
+    const size_t pixelsWidth;
+
+    DFT::RealDft realDft;
+    Spectrogram::SpectrumRenderer spectrumRenderer;
+    /* DFT of frame */
+    std::vector<std::complex<double>> dftSamples;
+    /* Moving average of frame compute time */
+    std::atomic<double> frameSeconds;
+
+    /* Frame waiting for a free row */
+    Buffer<double> *frame;
+    FrameSettings frameSettings;
+
+    bool finished;
+};
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include <algorithm>
+
+#include "WindowStage.hpp"
+
+namespace Pipeline {
+
+WindowStage::WindowStage(BufferQueue<double> &input, const std::vector<FrameLink *> &outputs, TransformStage *transform, const Audio::ChannelMixer &mixer, Snapshot<FrameSettings> &settings, LoadController &loadController, std::function<double()> frameSeconds, size_t primeFrames, SampleHistory *history) : Stage("Window"), input(input), outputs(outputs), transform(transform), mixer(mixer), channels(mixer.getOutputChannels()), settings(settings), frameSettings(settings.get()), loadController(loadController), degradation({frameSettings.samplesOverlap, 1, 1}), frameSeconds(frameSeconds), writeRegions(channels), primeFrames(primeFrames), history(history), hopSamples(0), hopFilled(0), framesSkipped(0), chunk(nullptr), chunkOffset(0), frameReady(false), frameChannel(0), framePosition(0), frameSampleRate(0), frameTimestamp(), frameSequence(0), endOfStream(false), endOfStreamSent(0), waitingOnInput(true) {
+    for (unsigned int c = 0; c < channels; c++)
+        windows.emplace_back(new DFT::SlidingWindow(frameSettings.dftSize));
+}
+
+void WindowStage::startHop() {
+    frameSettings = settings.acquire();
+
+    /* Restart the windows if N changed */
+    if (frameSettings.dftSize != windows[0]->getSize()) {
+        for (auto &window : windows)
+            window->setSize(frameSettings.dftSize);
+    }
+
+    /* Shed work if we're falling behind */
+    degradation = loadController.degrade(frameSettings.dftSize, frameSettings.samplesOverlap);
+    frameSettings.samplesOverlap = degradation.samplesOverlap;
+    frameSettings.pixelStep = degradation.pixelStep;
+
+    hopSamples = frameSettings.dftSize - frameSettings.samplesOverlap;
+}
+
+template <typename T>
+void WindowStage::stamp(Buffer<T> *buffer) {
+    buffer->sequence = frameSequence++;
+    buffer->position = framePosition;
+    buffer->span = frameSettings.dftSize;
+    buffer->channel = frameChannel;
+    buffer->sampleRate = frameSampleRate;
+    buffer->timestamp = frameTimestamp;
+}
+
+Progress WindowStage::step() {
+    /* Transform the window of the next channel in place with the lone
+     * transform, or emit a copy of it to the next output */
+    if (frameReady) {
+        if (transform) {
+            Buffer<uint32_t> *row = transform->acquireRow();
+            if (row == nullptr) {
+                waitingOnInput = false;
+                return Progress::Idle;
+            }
+
+            stamp(row);
+            transform->render(windows[frameChannel]->window(), frameSettings, row);
+        } else {
+            FrameLink &output = *outputs[frameSequence % outputs.size()];
+
+            Buffer<double> *frame = output.acquire();
+            if (frame == nullptr) {
+                waitingOnInput = false;
+                return Progress::Idle;
+            }
+
+            /* Frames are allocated for the largest DFT size, so this never allocates */
+            const double *window = windows[frameChannel]->window();
+            frame->data.resize(frameSettings.dftSize);
+            std::copy(window, window + frameSettings.dftSize, frame->data.begin());
+            stamp(frame);
+
+            output.push(frame, frameSettings);
+        }
+
+        if (++frameChannel == channels) {
+            frameChannel = 0;
+            frameReady = false;
+        }
+
+        return Progress::Busy;
+    }
+
+    /* Forward end of stream to the transform, or every output */
+    if (endOfStream && transform) {
+        Buffer<uint32_t> *row = transform->acquireRow();
+        if (row == nullptr) {
+            waitingOnInput = false;
+            return Progress::Idle;
+        }
+
+        transform->render(nullptr, frameSettings, row);
+        return Progress::Finished;
+    } else if (endOfStream) {
+        while (endOfStreamSent < outputs.size()) {
+            FrameLink &output = *outputs[(frameSequence + endOfStreamSent) % outputs.size()];
+
+            Buffer<double> *frame = output.acquire();
+            if (frame == nullptr) {
+                waitingOnInput = false;
+                return Progress::Idle;
+            }
+
+            frame->data.resize(0);
+            output.push(frame, frameSettings);
+            endOfStreamSent++;
+        }
+
+        return Progress::Finished;
+    }
+
+    /* Pop the next chunk of samples */
+    if (chunk == nullptr) {
+        if ((chunk = input.pop()) == nullptr) {
+            waitingOnInput = true;
+            return Progress::Idle;
+        }
+        chunkOffset = 0;
+
+        if (chunk->data.empty()) {
+            input.release(chunk);
+            chunk = nullptr;
+            endOfStream = true;
+
+            /* Pad a partial hop with zeros */
+            if (hopFilled > 0) {
+                size_t count = hopSamples - hopFilled;
+                for (auto &window : windows) {
+                    double *padding = window->writeRegion(count);
+                    std::fill(padding, padding + count, 0.0);
+                    window->commit(count);
+                }
+
+                framePosition += count;
+                hopFilled = 0;
+                frameReady = true;
+            }
+
+            return Progress::Busy;
+        }
+
+        /* Record the chunk, for a region to be read back later */
+        if (history)
+            history->write(chunk->data.data(), chunk->position, chunk->data.size() / mixer.getInputChannels());
+    }
+
+    size_t chunkFrames = chunk->data.size() / mixer.getInputChannels();
+
+    /* Prime the windows without emitting frames */
+    if (primeFrames > 0) {
+        size_t count = std::min(primeFrames, chunkFrames - chunkOffset);
+        for (unsigned int c = 0; c < channels; c++)
+            writeRegions[c] = windows[c]->writeRegion(count);
+        mixer.process(chunk->data.data() + chunkOffset * mixer.getInputChannels(), count, writeRegions.data());
+        for (auto &window : windows)
+            window->commit(count);
+        chunkOffset += count;
+        primeFrames -= count;
+    }
+
+    /* Slide new samples into the windows until a frame completes or the chunk runs out */
+    while (chunkOffset < chunkFrames) {
+        /* Pick up the latest settings at the start of each hop */
+        if (hopFilled == 0)
+            startHop();
+
+        /* Deinterleave and mix straight into the windows */
+        size_t count = std::min(hopSamples - hopFilled, chunkFrames - chunkOffset);
+        for (unsigned int c = 0; c < channels; c++)
+            writeRegions[c] = windows[c]->writeRegion(count);
+        mixer.process(chunk->data.data() + chunkOffset * mixer.getInputChannels(), count, writeRegions.data());
+        for (auto &window : windows)
+            window->commit(count);
+        chunkOffset += count;
+        hopFilled += count;
+
+        /* Position of the first sample in the window, clamped at the start of the stream */
+        uint64_t end = chunk->position + chunkOffset;
+        framePosition = (end > frameSettings.dftSize) ? end - frameSettings.dftSize : 0;
+        frameSampleRate = chunk->sampleRate;
+        /* Capture time of the newest sample in the window */
+        frameTimestamp = chunk->timestamp;
+        if (frameTimestamp != std::chrono::steady_clock::time_point())
+            frameTimestamp -= sampleDuration(chunkFrames - chunkOffset, chunk->sampleRate);
+
+        /* If we don't have a full hop of new samples, continue to consume more */
+        if (hopFilled < hopSamples)
+            continue;
+
+        hopFilled = 0;
+
+        /* Measure load: samples backlog and average compute time of a hop's frames */
+        size_t backlog = input.count() * chunkFrames + (chunkFrames - chunkOffset);
+        loadController.update(backlog, frameSeconds() * channels, hopSamples, transform ? 1 : outputs.size(), chunk->sampleRate);
+
+        /* Emit only one in degradation.skip frames */
+        if (++framesSkipped < degradation.skip)
+            continue;
+        framesSkipped = 0;
+
+        frameReady = true;
+        break;
+    }
+
+    /* Return chunk to the pool once consumed */
+    if (chunkOffset >= chunkFrames) {
+        input.release(chunk);
+        chunk = nullptr;
+    }
+
+    return Progress::Busy;
+}
+
+void WindowStage::wait(std::chrono::milliseconds rel_time) {
+    if (waitingOnInput)
+        input.waitReadable(rel_time);
+    else if (transform)
+        transform->wait(rel_time);
+    else
+        outputs[(frameSequence + endOfStreamSent) % outputs.size()]->waitWritable(rel_time);
+}
+}
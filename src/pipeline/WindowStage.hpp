@@ -0,0 +1,97 @@
+#ifndef _WINDOWSTAGE_HPP
+#define _WINDOWSTAGE_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "Stage.hpp"
+#include "BufferQueue.hpp"
+#include "FrameLink.hpp"
+#include "TransformStage.hpp"
+#include "Snapshot.hpp"
+#include "LoadController.hpp"
+#include "SampleHistory.hpp"
+#include "audio/ChannelMixer.hpp"
+#include "dft/SlidingWindow.hpp"
+
+namespace Pipeline {
+
+/* Slides chunks of interleaved samples into the overlap window of each
+ * channel, mixed by the channel mixer on the way, and emits a frame per
+ * channel for every full hop, with the latest settings degraded by the load
+ * controller. Frames are dealt out round-robin over the outputs, so a gather
+ * stage can put the transform replicas' rows back in order. A lone
+ * transform is run on this stage's step instead, straight from the window,
+ * so the window is never copied into a frame. At the end of
+ * the stream, a partial hop is padded with zeros and every output gets an
+ * empty frame. The windows can be primed with the frames before the start
+ * of a range, so its first frame is a full window. Chunks can be recorded
+ * into a sample history on the way in. */
+class WindowStage : public Stage {
+  public:
+    WindowStage(BufferQueue<double> &input, const std::vector<FrameLink *> &outputs, TransformStage *transform, const Audio::ChannelMixer &mixer, Snapshot<FrameSettings> &settings, LoadController &loadController, std::function<double()> frameSeconds, size_t primeFrames = 0, SampleHistory *history = nullptr);
+
+    virtual Progress step();
+    virtual void wait(std::chrono::milliseconds rel_time);
+
+  private:
+    /* Start a hop with the latest settings */
+    void startHop();
+    /* Stamp a frame or row with the metadata of the next frame */
+    template <typename T>
+    void stamp(Buffer<T> *buffer);
+
+    BufferQueue<double> &input;
+    /* Frame links to the transforms, or the lone transform run here */
+    const std::vector<FrameLink *> outputs;
+    TransformStage *transform;
+
+    /* Input channels to analysis channels */
+    const Audio::ChannelMixer mixer;
+    const unsigned int channels;
+
+    /* Settings published by the interface, picked up once per hop */
+    Snapshot<FrameSettings> &settings;
+    FrameSettings frameSettings;
+
+    /* Sheds work when the pipeline falls behind */
+    LoadController &loadController;
+    LoadController::Degradation degradation;
+    /* Average frame compute time of the transform stages */
+    std::function<double()> frameSeconds;
+
+    /* Overlapped Samples, per channel */
+    std::vector<std::unique_ptr<DFT::SlidingWindow>> windows;
+    std::vector<double *> writeRegions;
+    /* Frames left to slide into the windows before the first hop */
+    size_t primeFrames;
+    /* Record of the input, if any */
+    SampleHistory *history;
+    /* Hop for the current frame, and new frames in it so far */
+    size_t hopSamples;
+    size_t hopFilled;
+    /* Hops since the last frame emitted, for frame skipping */
+    unsigned int framesSkipped;
+
+    /* Chunk being consumed, offset in frames */
+    Buffer<double> *chunk;
+    size_t chunkOffset;
+
+    /* Frames waiting for a free output, one per channel from frameChannel on */
+    bool frameReady;
+    unsigned int frameChannel;
+    uint64_t framePosition;
+    unsigned int frameSampleRate;
+    std::chrono::steady_clock::time_point frameTimestamp;
+    uint64_t frameSequence;
+
+    /* End of stream forwarded to this many outputs */
+    bool endOfStream;
+    size_t endOfStreamSent;
+
+    bool waitingOnInput;
+};
+}
+
+#endif
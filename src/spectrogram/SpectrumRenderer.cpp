@@ -76,7 +76,7 @@ static uint32_t valueToPixel_Grayscale(double value) {
     return (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(c) << 8) | (static_cast<uint32_t>(c));
 }
 
-void SpectrumRenderer::render(std::vector<uint32_t> &pixels, const std::vector<std::complex<double>> &dft) {
+void SpectrumRenderer::render(std::vector<uint32_t> &pixels, const std::vector<std::complex<double>> &dft, unsigned int pixelStep) {
     unsigned int i;
     uint32_t (*valueToPixel)(double) = nullptr;
     double (*processMagnitude)(double) = nullptr;
@@ -95,9 +95,13 @@ void SpectrumRenderer::render(std::vector<uint32_t> &pixels, const std::vector<s
 
     /* Generate pixel row for this DFT */
     float index_scale = static_cast<float>(dft.size()) / static_cast<float>(pixels.size());
-    for (i = 0; i < pixels.size(); i++) {
+    for (i = 0; i < pixels.size(); i += pixelStep) {
         double magnitude = processMagnitude(std::abs(dft[static_cast<unsigned int>(index_scale * static_cast<float>(i))]));
         pixels[i] = valueToPixel(normalize(magnitude, settings.magnitudeMin, settings.magnitudeMax));
+
+        /* Repeat for a coarser row */
+        for (unsigned int j = 1; j < pixelStep && i + j < pixels.size(); j++)
+            pixels[i + j] = pixels[i];
     }
 }
 
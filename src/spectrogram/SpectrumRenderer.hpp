@@ -16,10 +16,11 @@ class SpectrumRenderer {
 
     SpectrumRenderer(double magnitudeMin, double magnitudeMax, bool magnitudeLog, ColorScheme colors);
 
-    /* Render a new pixel row from a DFT vector */
-    void render(std::vector<uint32_t> &pixels, const std::vector<std::complex<double>> &dft);
+    /* Render a new pixel row from a DFT vector, computing every pixelStep-th
+     * pixel and repeating it over the next pixelStep - 1 for a coarser row */
+    void render(std::vector<uint32_t> &pixels, const std::vector<std::complex<double>> &dft, unsigned int pixelStep = 1);
 
-    struct {
+    struct Settings {
         double magnitudeMin;
         double magnitudeMax;
         bool magnitudeLog;
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <getopt.h>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include "audio/UdpPacket.hpp"
+
+/* Test sender for UdpAudioSource: streams a tone sweep, or raw PCM from
+ * stdin, in real time as UDP PCM packets, optionally losing and reordering
+ * some of them. */
+
+using namespace Audio;
+
+struct Options {
+    unsigned int sampleRate = 24000;
+    unsigned int channels = 1;
+    unsigned int frames = 256;
+    SampleFormat format = SampleFormat::S16;
+    bool readStdin = false;
+    double loss = 0.0;
+    double reorder = 0.0;
+};
+
+void print_usage(std::string progname) {
+    std::cerr << "Usage: " << progname << " [options] <host:port>\n"
+                 "\n"
+                 "    -h,--help                   Help\n"
+                 "    -r,--sample-rate <rate>     Sample rate (default 24000)\n"
+                 "    -c,--channels <count>       Channels (default 1)\n"
+                 "    --frames <count>            Frames per packet (default 256, max " << UdpPacketHeader::MaxFrames << ")\n"
+                 "    --format <format>           Sample format [s16, f32] (default s16)\n"
+                 "    --stdin                     Send raw PCM of the sample format from stdin,\n"
+                 "                                    instead of a tone sweep\n"
+                 "    --loss <percentage>         Drop packets at random (default 0)\n"
+                 "    --reorder <percentage>      Swap packets with the next at random (default 0)\n";
+}
+
+static int open_socket(std::string address) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos)
+        return -1;
+
+    std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+
+    struct addrinfo hints, *result;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (ret != 0) {
+        std::cerr << "Error resolving " << address << ": " << gai_strerror(ret) << "\n";
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = result; ai != nullptr; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0)
+            continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0)
+        std::cerr << "Error connecting to " << address << ": " << std::strerror(errno) << "\n";
+
+    return fd;
+}
+
+/* Fill a packet's samples, false at the end of stdin */
+static bool fill_samples(const Options &options, uint64_t position, uint8_t *samples) {
+    size_t bytes = options.frames * options.channels * sampleBytes(options.format);
+
+    if (options.readStdin) {
+        size_t filled = 0;
+        while (filled < bytes) {
+            ssize_t ret = read(STDIN_FILENO, samples + filled, bytes - filled);
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret <= 0)
+                return false;
+            filled += static_cast<size_t>(ret);
+        }
+        return true;
+    }
+
+    /* Sweep 100 Hz to a quarter of the sample rate and back every 10 seconds */
+    for (size_t i = 0; i < options.frames; i++) {
+        double t = static_cast<double>(position + i) / options.sampleRate;
+        double sweep = std::fabs(std::fmod(t, 10.0) - 5.0) / 5.0;
+        double frequency = 100.0 + sweep * (options.sampleRate / 4.0 - 100.0);
+        double value = 0.5 * std::sin(2 * M_PI * frequency * t);
+
+        for (size_t c = 0; c < options.channels; c++) {
+            uint8_t *sample = samples + (i * options.channels + c) * sampleBytes(options.format);
+            uint32_t bits;
+            if (options.format == SampleFormat::S16) {
+                bits = static_cast<uint16_t>(static_cast<int16_t>(value * 32767.0));
+            } else {
+                float f = static_cast<float>(value);
+                std::memcpy(&bits, &f, sizeof(bits));
+            }
+            for (size_t b = 0; b < sampleBytes(options.format); b++)
+                sample[b] = static_cast<uint8_t>(bits >> (8 * b));
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+
+    static struct option long_options[] = {
+        {"help", no_argument, 0, 'h'},
+        {"sample-rate", required_argument, 0, 'r'},
+        {"channels", required_argument, 0, 'c'},
+        {"frames", required_argument, 0, 0},
+        {"format", required_argument, 0, 0},
+        {"stdin", no_argument, 0, 0},
+        {"loss", required_argument, 0, 0},
+        {"reorder", required_argument, 0, 0},
+        {0, 0, 0, 0},
+    };
+
+    while (1) {
+        int options_index;
+        int c = getopt_long(argc, argv, "hr:c:", long_options, &options_index);
+
+        if (c == -1)
+            break;
+
+        try {
+            if (c == 'h') {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            } else if (c == 'r') {
+                options.sampleRate = static_cast<unsigned int>(std::stoul(optarg));
+            } else if (c == 'c') {
+                options.channels = static_cast<unsigned int>(std::stoul(optarg));
+            } else if (c == 0) {
+                std::string option_name = long_options[options_index].name;
+                std::string option_arg = (long_options[options_index].has_arg == required_argument) ? optarg : "";
+
+                if (option_name == "frames") {
+                    options.frames = static_cast<unsigned int>(std::stoul(option_arg));
+                } else if (option_name == "format") {
+                    if (option_arg == "s16")
+                        options.format = SampleFormat::S16;
+                    else if (option_arg == "f32")
+                        options.format = SampleFormat::F32;
+                    else
+                        throw std::invalid_argument(option_name);
+                } else if (option_name == "stdin") {
+                    options.readStdin = true;
+                } else if (option_name == "loss") {
+                    options.loss = std::stod(option_arg) / 100.0;
+                } else if (option_name == "reorder") {
+                    options.reorder = std::stod(option_arg) / 100.0;
+                }
+            } else {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } catch (const std::invalid_argument &e) {
+            std::cerr << "Invalid value for " << ((c == 0) ? long_options[options_index].name : std::string(1, static_cast<char>(c))) << ".\n\n";
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.sampleRate == 0 || options.channels == 0 || options.channels > 0xffff || options.frames == 0 || options.frames > UdpPacketHeader::MaxFrames || (argc - optind) != 1) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = open_socket(argv[optind]);
+    if (fd < 0)
+        return EXIT_FAILURE;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    UdpPacketHeader header;
+    header.sequence = 0;
+    header.timestamp = 0;
+    header.sampleRate = options.sampleRate;
+    header.channels = static_cast<uint16_t>(options.channels);
+    header.format = options.format;
+
+    size_t packetSize = UdpPacketHeader::Size + options.frames * options.channels * sampleBytes(options.format);
+    std::vector<uint8_t> packet(packetSize), held;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    while (fill_samples(options, header.timestamp, packet.data() + UdpPacketHeader::Size)) {
+        header.encode(packet.data());
+
+        /* Lose, hold back for after the next, or send */
+        if (chance(random) < options.loss) {
+        } else if (held.empty() && chance(random) < options.reorder) {
+            held = packet;
+        } else {
+            if (send(fd, packet.data(), packet.size(), 0) < 0 && errno != ECONNREFUSED)
+                std::cerr << "Error sending packet: " << std::strerror(errno) << "\n";
+            if (!held.empty()) {
+                send(fd, held.data(), held.size(), 0);
+                held.clear();
+            }
+        }
+
+        header.sequence++;
+        header.timestamp += options.frames;
+
+        /* Pace the tone in real time, stdin is paced by its writer */
+        if (!options.readStdin)
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(header.timestamp) / options.sampleRate)));
+    }
+
+    close(fd);
+
+    return 0;
+}